@@ -21,6 +21,20 @@ void* cameraThreadRoutine(void* arg) {
 int main(int argc, char* argv[]) {
     signal(SIGINT, stopHandler);
 
+    // cameraInitEx takes everything as options, e.g. to trade resolution for frame rate:
+    // CameraOptions options;
+    // cameraDefaultOptions(&options);
+    // options.width = 320;
+    // options.height = 240;
+    // options.fps = 60;
+    // options.sensorMode = CAMERA_MODE_MAX_FPS; // i.e. a 2x2 binned mode instead of full readout
+    // options.bandTop = 0.5; // Only read out the lower half the slices use
+    // options.bandHeight = 0.5;
+    // options.lockExposure = 1; // Constant frame interval & exposure once AE settles
+    // options.pixelFormat = CAMERA_FORMAT_YUV420; // Detect on the Y plane of a small stream...
+    // options.recordWidth = 1280;                  // ...and record a full size one beside it
+    // options.recordHeight = 960;
+    // camera = cameraInitEx(&options);
     camera = cameraInit();
     if (!camera) {
         fprintf(stderr, "Failed to initialize the camera.\n");
@@ -28,6 +42,15 @@ int main(int argc, char* argv[]) {
     }
     printf("Camera initialized successfully.\n");
 
+    // Optionally keep a ring of raw frames for post-incident analysis
+    // (i.e. 300 slots at 30fps holds the last 10 seconds before a crash)
+    // cameraEnableRecording(camera, "/home/pi/waymore.rec", 300, 1);
+
+    // Optionally keep frame processing off the other cores' noise (needs root)
+    // cameraUseHugePages(camera, 1);
+    // cameraLockMemory(camera);
+    // cameraSetThreadPolicy(camera, CAMERA_THREAD_PROCESSING, 80, 3);
+
     printf("Starting the camera. Press Ctrl+C to stop.\n");
     pthread_t cameraThread;
     if (pthread_create(&cameraThread, NULL, cameraThreadRoutine, NULL) != 0) {
@@ -43,6 +66,11 @@ int main(int argc, char* argv[]) {
         // being a parameter
         // int* distances = getLineDistances(camera); // Retrieve the distances array
         // printf("Last index value: %d\n", distances[4]);
+
+        // Or every frame since the last poll, i.e. to estimate how fast the line moves:
+        // LineHistoryRecord history[16];
+        // int count = getLineHistory(camera, lastTimestampNs, history, 16);
+        // if (count > 0) lastTimestampNs = history[count - 1].timestampNs;
         
         usleep(100); // 100ms
     }
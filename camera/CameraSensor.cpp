@@ -1,177 +1,215 @@
 #include "CameraSensor.hpp"
+#include "LibcameraSource.hpp"
 
-CameraSensor::CameraSensor() {
-    // Loads the library's camera manager for camera acquisition
-    cameraManager = std::make_unique<CameraManager>();
-    cameraManager->start();
+CameraSensor::CameraSensor()
+    : CameraSensor(std::make_unique<LibcameraSource>(),
+                    std::make_unique<FrameProcessor>(5, 0.95, 90, 170, true)) {}
 
-    // Identifies all cameras attached to the device
-    auto attachedCameras = cameraManager->cameras();
-    if (attachedCameras.empty()) {
-        std::cerr << "No cameras were identified on the system." << std::endl;
-        cameraManager->stop();
-        exit(EXIT_FAILURE);
+CameraSensor::CameraSensor(std::unique_ptr<FrameSource> source,
+                            std::unique_ptr<FrameProcessor> processor)
+    : source(std::move(source)), frameProcessor(std::move(processor)) {}
+
+CameraSensor::~CameraSensor() {
+    // Let the recorder hand back its in-flight frame while the camera still takes
+    // requests, then stop deliveries
+    {
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        recorder.reset();
     }
+    source->stop();
+}
+
+void CameraSensor::startCamera() {
+    source->start([this](const FrameSource::Frame &frame) { frameComplete(frame); });
+}
 
-    // Acquire only the first camera (only option we have) & put a lock on it
-    camera = attachedCameras.front();
-    if (camera->acquire() != 0) {
-        std::cerr << "Failed to acquire camera." << std::endl;
-        cameraManager->stop();
-        exit(EXIT_FAILURE);
+int CameraSensor::configCamera(const uint_fast32_t width, const uint_fast32_t height,
+                                const PixelFormat pixelFormat, const StreamRole role) {
+    int result = source->configure(width, height, pixelFormat, role);
+    if (result != 0) {
+        return result;
     }
-    std::cout << "Acquired camera: " << camera->id() << std::endl;
 
-    // Create & config frame processor
-    frameProcessor = std::make_unique<FrameProcessor>(5, 0.95, 90, 170, true);
+    // The frame size is known from here on; lay out & touch the scratch arena now
+    // rather than on the first frames
+    const FrameSource::Format &format = source->getFormat();
+    try {
+        frameProcessor->setInputFormat(format.fourcc, format.stride);
+    } catch (const std::exception &e) {
+        std::cerr << "Can't process " << libcamera::PixelFormat(format.fourcc).toString() << ": "
+                    << e.what() << std::endl;
+        return -ENOTSUP;
+    }
+    frameProcessor->setFrameWindow(format.fullHeight, format.rowOffset);
+    return prefaultScratch();
 }
 
-CameraSensor::~CameraSensor() {
-    camera->stop();
-    camera->release();
-    camera.reset();
-    cameraManager->stop();
+int CameraSensor::prefaultScratch() {
+    const FrameSource::Format &format = source->getFormat();
+    try {
+        frameProcessor->prefault(cv::Size(format.width, format.height));
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to prepare processing scratch: " << e.what() << std::endl;
+        return -ENOMEM;
+    }
+    return 0;
 }
 
-void CameraSensor::startCamera() {
-    sendRequests();
-    camera->requestCompleted.connect(this, &CameraSensor::requestComplete);
-    camera->start();
-    for (std::unique_ptr<Request>& request : requests) {
-        camera->queueRequest(request.get());
+void CameraSensor::frameComplete(const FrameSource::Frame &frame) {
+    if (policyGeneration.load(std::memory_order_acquire) != appliedGeneration) {
+        applyProcessingPolicy();
+    }
+
+    // With a recording stream only its buffer can go to the recorder; the processing
+    // buffer goes back as soon as the frame is processed
+    const FrameSource::Frame &toRecord = frame.recording ? *frame.recording : frame;
+    bool recorded = false;
+    cv::Mat image;
+    try {
+        renderFrame(image, frame);
+
+        // The recorder releases the frame itself once it copied the pixels
+        recorded = recordFrame(toRecord);
+    } catch (const std::exception &e) {
+        std::cerr << "Error trying to render frame: " << e.what() << std::endl;
+    }
+    if (!recorded) {
+        source->release(toRecord);
+    }
+    if (frame.recording) {
+        source->release(frame);
     }
 }
 
-int CameraSensor::configCamera(const uint_fast32_t width, const uint_fast32_t height,
-                                const PixelFormat pixelFormat, const StreamRole role) {
-    // Create configuration profile for the camera
-    config = camera->generateConfiguration({ role });
-    StreamConfiguration &streamConfig = config->at(0);
-    std::cout << "Default configuration is: " << streamConfig.toString() << std::endl;
-
-    // Adjust & validate the desired configuration
-    streamConfig.size.width = width;
-    streamConfig.size.height = height;
-    streamConfig.pixelFormat = pixelFormat;
-    config->validate();
-    if (camera->configure(config.get()) != 0) {
-        std::cerr << "Failed to config camera: " << camera->id() << std::endl;
-        return -EINVAL;
+void CameraSensor::applyProcessingPolicy() {
+    ThreadPolicy policy;
+    bool prefaultStackPages;
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        policy = processingPolicy;
+        prefaultStackPages = memoryLocked;
+        appliedGeneration = policyGeneration.load(std::memory_order_relaxed);
     }
-    std::cout << "Selected configuration is: " << streamConfig.toString() << std::endl;
 
-    // Allocate the buffers & map the memory we need for the incoming camera streams
-    allocator = std::make_unique<FrameBufferAllocator>(camera);
+    const int result = applyThreadPolicy(pthread_self(), policy);
 
-    for (StreamConfiguration &cfg : *config) {
-        // Allocate buffers via stream inputs
-        Stream* stream = cfg.stream();
-        if (allocator->allocate(cfg.stream()) < 0) {
-            std::cerr << "Failed to allocate buffers" << std::endl;
-            return -ENOMEM;
+    // A newer policy may have arrived meanwhile: leave it pending until it's applied
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        if (policyGeneration.load(std::memory_order_relaxed) == appliedGeneration) {
+            processingPolicyResult = result;
         }
+    }
+    if (prefaultStackPages) {
+        prefaultStack(256 * 1024);
+    }
+}
 
-        size_t allocated = allocator->buffers(cfg.stream()).size();
-        std::cout << "Allocated " << allocated << " buffers for stream" << std::endl;
-
-        // Pre-map the buffers so we don't recursively refresh memory regions when rendering
-        // Note: Multi-plane buffering all have the same file descriptor
-        // starting at 20, increasing
-        for (const std::unique_ptr<FrameBuffer> &buffer : allocator->buffers(stream)) {
-            // Iterate through all possible plane associated with a buffer
-            // (i.e. YUV420 has 3; XRGB8888 has 1) 
-            for (unsigned int i = 0; i < buffer->planes().size(); i++) {
-                // Accounts for only YUV & XRGB8888 due to my integration for opencv.
-                // Adjustments not accounted for other pixel formats.
-                if (i == 0) {
-                    // Maps the individual plane's buffer
-                    const FrameBuffer::Plane &plane = buffer->planes()[i];
-                    
-                    void* data_ = mmap(NULL, plane.length, PROT_READ | PROT_WRITE, MAP_SHARED,
-                                        plane.fd.get(), 0);
-                    if (data_ == MAP_FAILED) {
-                        throw std::runtime_error("Failed to map buffer for plane");
-                    }
-
-                    // Store mapped buffer for later use so we don't need to loop remapping
-                    mappedBuffers[buffer.get()].push_back(
-                        libcamera::Span<uint8_t>(static_cast<uint8_t*>(data_), plane.length)
-                    );
-                }
-            }
-            // Store the stream's buffer for request
-            frameBuffers[stream].push(buffer.get());
-        }
+int CameraSensor::setThreadPolicy(ThreadRole role, const ThreadPolicy &policy) {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    if (role == ThreadRole::Processing) {
+        processingPolicy = policy;
+        processingPolicyResult = -EINPROGRESS;
+        policyGeneration.fetch_add(1, std::memory_order_release);
+        return 0;
     }
 
-    return 0;
+    recorderPolicy = policy;
+    recorderPolicySet = true;
+    std::lock_guard<std::mutex> recorderLock(recorderMutex);
+    return recorder ? recorder->applyThreadPolicy(policy) : 0;
 }
 
-void CameraSensor::sendRequests() {
-    // Acquire the allocated buffers for streams stored in CameraConfiguration by libcamera
-    // to create the requests (we can percieve request as a promise and fullfill event)
-    for (StreamConfiguration &cfg : *config) {
-        Stream* stream = cfg.stream();
-        
-        std::unique_ptr<Request> request = camera->createRequest();
-        if (!request) {
-            std::cerr << "Can't create request" << std::endl;
-            throw std::runtime_error("Failed to make a request");
-        }
-        requests.push_back(std::move(request));
+int CameraSensor::getProcessingPolicyResult() {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    return processingPolicyResult;
+}
 
-        // Seperate the frame buffer associated with the stream
-        FrameBuffer* buffer = frameBuffers[stream].front();
+int CameraSensor::lockMemory() {
+    const FrameSource::Format &format = source->getFormat();
+    if (format.width == 0) {
+        std::cerr << "Camera must be configured before locking memory" << std::endl;
+        return -EINVAL;
+    }
 
-        if (requests.back()->addBuffer(stream, buffer) < 0) {
-            throw std::runtime_error("Failed to add buffer to request");
-        }
+    int result = prefaultScratch();
+    if (result != 0) {
+        return result;
+    }
+    result = lockProcessMemory();
+    if (result != 0) {
+        return result;
     }
+
+    // The processing thread's stack is prefaulted on its next frame
+    std::lock_guard<std::mutex> lock(policyMutex);
+    memoryLocked = true;
+    policyGeneration.fetch_add(1, std::memory_order_release);
+    return 0;
 }
 
-void CameraSensor::requestComplete(Request* request) {
-    if (request->status() == Request::RequestCancelled) {
-        return;
+int CameraSensor::useHugePages(bool enabled) {
+    frameProcessor->setHugePages(enabled);
+    return (source->getFormat().width == 0) ? 0 : prefaultScratch();
+}
+
+int CameraSensor::enableRecording(const std::string &path, uint32_t slotCount, uint32_t everyNth) {
+    const FrameSource::Format &format = (source->getRecordingFormat().width > 0)
+        ? source->getRecordingFormat() : source->getFormat();
+    if (format.width == 0) {
+        std::cerr << "Camera must be configured before enabling recording" << std::endl;
+        return -EINVAL;
     }
 
-    cv::Mat frame;
-    const std::map<const Stream*, FrameBuffer*> &buffers =
-        request->buffers();
-    
-    // Iterate through all the request's buffers & render its image frame
-    for (auto &[stream, buffer] : buffers) {
-        if (buffer->metadata().status == FrameMetadata::FrameSuccess) {
-            try {
-                renderFrame(frame, buffer);
-                request->reuse(Request::ReuseBuffers);
-                camera->queueRequest(request);
-            } catch (const std::exception &e) {
-                std::cerr << "Error trying to render frame: " << e.what() << std::endl;
-            }
+    // Built outside the locks; frames keep going to the previous recorder meanwhile
+    std::unique_ptr<FrameRecorder> next;
+    try {
+        next = std::make_unique<FrameRecorder>(path, format.width, format.height, format.stride,
+                                                format.fourcc, slotCount, everyNth);
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to enable recording: " << e.what() << std::endl;
+        return -EIO;
+    }
+
+    std::unique_ptr<FrameRecorder> previous;
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        if (recorderPolicySet) {
+            next->applyThreadPolicy(recorderPolicy);
         }
+        std::lock_guard<std::mutex> recorderLock(recorderMutex);
+        previous = std::move(recorder);
+        recorder = std::move(next);
     }
+    // The previous recorder hands back its in-flight frame once no lock is held
+    return 0;
 }
 
-void CameraSensor::renderFrame(cv::Mat &frame, const libcamera::FrameBuffer *buffer) {
-    const StreamConfiguration &streamConfig = config->at(0);
+bool CameraSensor::recordFrame(const FrameSource::Frame &frame) {
+    std::lock_guard<std::mutex> lock(recorderMutex);
+    if (!recorder || !recorder->shouldRecord()) {
+        return false;
+    }
 
-    try {
-        // Find the mapped buffer associated with the given FrameBuffer
-        auto item = mappedBuffers.find(const_cast<libcamera::FrameBuffer*>(buffer));
-        if (item == mappedBuffers.end()) {
-            std::cerr << "Mapped buffer not found, cannot display frame" << std::endl;
-            return;
-        }
+    FrameRecorder::FrameInfo info;
+    info.sequence = frame.sequence;
+    info.timestampNs = frame.timestampNs;
+    info.exposureUs = frame.exposureUs;
+
+    return recorder->submit(frame.data, info, [this, frame]() { source->release(frame); });
+}
+
+void CameraSensor::renderFrame(cv::Mat &frame, const FrameSource::Frame &source) {
+    const FrameSource::Format &format = this->source->getFormat();
 
-        // Retrieve the pre-mapped buffer
-        const std::vector<libcamera::Span<uint8_t>> &retrievedBuffers = item->second;
-        if (retrievedBuffers.empty() || retrievedBuffers[0].data() == nullptr) {
-            std::cerr << "Mapped buffer is empty or data is null, cannot display frame" << std::endl;
+    try {
+        if (source.data == nullptr) {
+            std::cerr << "Frame data is null, cannot display frame" << std::endl;
             return;
         }
 
-        frameProcessor->processFrame(frame, streamConfig.size.height, streamConfig.size.width,
-                                        retrievedBuffers[0].data());
+        frameProcessor->processFrame(frame, format.height, format.width, source.data, source.sequence,
+                                        source.timestampNs);
     } catch (const std::exception &e) {
         std::cerr << "Error rendering frame: " << e.what() << std::endl;
     }
@@ -198,3 +236,147 @@ int* CameraSensor::getDistances() {
     delete[] acquiredDistances;
     return distancesCopy;
 }
+
+int CameraSensor::getDistancesF(float* pixels, float* normalized, int maxSlices) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getDistancesF(pixels, normalized, maxSlices);
+}
+
+int CameraSensor::getCandidates(SliceCandidates* out, int maxSlices) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getCandidates(out, maxSlices);
+}
+
+int CameraSensor::getStatus(SliceStatus* out, int maxSlices) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getStatus(out, maxSlices);
+}
+
+int CameraSensor::getSnapshot(SliceResult* out, int maxSlices) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getSnapshot(out, maxSlices);
+}
+
+void CameraSensor::setCentroidMode(FrameProcessor::CentroidMode mode) {
+    frameProcessor->setCentroidMode(mode);
+}
+
+int CameraSensor::setSlicePeriods(const std::vector<int> &periods) {
+    try {
+        frameProcessor->setSliceSchedule(SliceSchedule(periods));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -EINVAL;
+    }
+    return 0;
+}
+
+void CameraSensor::setSpeed(double speed) {
+    frameProcessor->setSpeed(speed);
+}
+
+void CameraSensor::enableDeadlines(double fps) {
+    frameProcessor->enableDeadlines(fps, DeadlineGovernor::Options());
+}
+
+DeadlineGovernor::Stats CameraSensor::getDeadlineStats() {
+    return frameProcessor->getDeadlineStats();
+}
+
+FrameProcessor::MemoryStats CameraSensor::getMemoryStats() {
+    return frameProcessor->getMemoryStats();
+}
+
+int CameraSensor::setSliceRows(int frameHeight, const std::vector<cv::Range> &rows) {
+    try {
+        return setSliceLayout(SliceLayout::fromRows(frameHeight, rows));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -EINVAL;
+    }
+}
+
+int CameraSensor::setPerspectiveSlices(int frameHeight, int topRow, double growth) {
+    try {
+        return setSliceLayout(SliceLayout::perspective(frameHeight, frameProcessor->getSlices(), topRow, growth));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -EINVAL;
+    }
+}
+
+int CameraSensor::setSliceLayout(const SliceLayout &layout) {
+    // With a band of interest, a slice wholly outside the delivered rows would never be measured
+    const FrameSource::Format &format = source->getFormat();
+    if (format.fullHeight > 0) {
+        const SliceLayout window = layout.scaledTo(format.fullHeight).croppedTo(format.rowOffset, format.height);
+        for (int i = 0; i < window.size(); i++) {
+            if (window[i].empty()) {
+                std::cerr << "Slice " << i << " lies outside the band of interest (rows " << format.rowOffset
+                            << "-" << format.rowOffset + format.height << " of " << format.fullHeight << ")"
+                            << std::endl;
+                return -EINVAL;
+            }
+        }
+    }
+    frameProcessor->setSliceLayout(layout);
+    return 0;
+}
+
+int CameraSensor::loadLensCalibration(const std::string &path) {
+    try {
+        frameProcessor->setLensModel(std::make_unique<LensModel>(path));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -EINVAL;
+    }
+    return 0;
+}
+
+int CameraSensor::loadGroundCalibration(const std::string &path) {
+    try {
+        frameProcessor->setGroundMapper(std::make_unique<GroundMapper>(path));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -EINVAL;
+    }
+    return 0;
+}
+
+int CameraSensor::getHistory(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getHistory(sinceTimestampNs, out, maxCount);
+}
+
+void CameraSensor::setHistoryLength(size_t records) {
+    frameProcessor->setHistoryLength(records);
+}
+
+int CameraSensor::getGroundPoints(GroundPoint* out, int maxSlices) {
+    if (!frameProcessor) {
+        std::cerr << "FrameProcessor is not initialized." << std::endl;
+        return 0;
+    }
+
+    return frameProcessor->getGroundPoints(out, maxSlices);
+}
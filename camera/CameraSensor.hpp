@@ -1,56 +1,97 @@
 #ifndef _CAMERASENSOR_H_
 #define _CAMERASENSOR_H_
 
+#include <atomic>
 #include <iostream>
-#include <queue>
-#include <sys/mman.h> // mmap & munmap
+#include <memory>
+#include <mutex>
 
-#include <libcamera/libcamera.h>
 #include <opencv2/opencv.hpp>
 
 #include "FrameProcessor.hpp"
+#include "FrameRecorder.hpp"
+#include "FrameSource.hpp"
+#include "Realtime.hpp"
 
 class CameraSensor {
 public:
-    using Camera = libcamera::Camera;
-    using CameraManager = libcamera::CameraManager;
-    using CameraConfiguration = libcamera::CameraConfiguration;
-    using Stream = libcamera::Stream;
-    using StreamRole = libcamera::StreamRole;
     using PixelFormat = libcamera::PixelFormat;
-    using StreamConfiguration = libcamera::StreamConfiguration;
-    using FrameBuffer = libcamera::FrameBuffer;
-    using FrameBufferAllocator = libcamera::FrameBufferAllocator;
-    using FrameMetadata = libcamera::FrameMetadata;
-    using Request = libcamera::Request;
+    using StreamRole = libcamera::StreamRole;
+
+    enum class ThreadRole {
+        Processing, // The source's completion thread; frames are processed on it
+        Recorder    // FrameRecorder's writer
+    };
 
     CameraSensor(); // Holds initializating steps for the camera
+    CameraSensor(std::unique_ptr<FrameSource> source, std::unique_ptr<FrameProcessor> processor);
     ~CameraSensor();
 
     int configCamera(const uint_fast32_t width, const uint_fast32_t height,
                     const PixelFormat pixelFormat, const StreamRole role);
     void startCamera();
+    int enableRecording(const std::string &path, uint32_t slotCount, uint32_t everyNth);
     int* getDistances();
+    int getDistancesF(float* pixels, float* normalized, int maxSlices);
+    int getCandidates(SliceCandidates* out, int maxSlices);
+    int getStatus(SliceStatus* out, int maxSlices);
+    int getSnapshot(SliceResult* out, int maxSlices);
+    void setCentroidMode(FrameProcessor::CentroidMode mode);
+    int setSlicePeriods(const std::vector<int> &periods);
+    void setSpeed(double speed);
+    void enableDeadlines(double fps);
+    DeadlineGovernor::Stats getDeadlineStats();
+    FrameProcessor::MemoryStats getMemoryStats();
+    int setSliceRows(int frameHeight, const std::vector<cv::Range> &rows);
+    int setPerspectiveSlices(int frameHeight, int topRow, double growth);
+    int loadLensCalibration(const std::string &path);
+    int loadGroundCalibration(const std::string &path);
+    int getGroundPoints(GroundPoint* out, int maxSlices);
+    int getHistory(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount);
+    void setHistoryLength(size_t records); // Before startCamera
 
-private:
-    std::shared_ptr<Camera> camera;
-    std::unique_ptr<CameraManager> cameraManager;
-    std::unique_ptr<CameraConfiguration> config;
-    std::unique_ptr<FrameBufferAllocator> allocator;
-    std::vector<std::unique_ptr<Request>> requests;
+    // The processing thread belongs to the source, so its policy is applied from the
+    // next frame it delivers; the recorder's is applied right away
+    int setThreadPolicy(ThreadRole role, const ThreadPolicy &policy);
+
+    // What applying the processing policy returned: -EINPROGRESS until the thread's
+    // next frame, then 0 or the negative errno it failed with
+    int getProcessingPolicyResult();
 
-    // House the Span (mapped memory: 1st param = region offset of file; 2nd param = size)
-    std::map<FrameBuffer*, std::vector<libcamera::Span<uint8_t>>> mappedBuffers;
+    // Prefaults the processing scratch for the configured size, then locks all memory
+    int lockMemory();
 
-    // Pair that formulate each image
-    std::map<Stream*, std::queue<FrameBuffer*>> frameBuffers;
+    // Rebuilds the scratch arena on transparent huge pages. Call before startCamera.
+    int useHugePages(bool enabled);
+
+private:
+    // Libcamera on the car, FakeFrameSource off it
+    std::unique_ptr<FrameSource> source;
 
     // Modularize frame processing event
     std::unique_ptr<FrameProcessor> frameProcessor;
 
-    void sendRequests();
-    void requestComplete(Request* request);
-    void renderFrame(cv::Mat &frame, const libcamera::FrameBuffer *buffer);
+    // Optional raw frame ring for post-incident analysis
+    std::unique_ptr<FrameRecorder> recorder;
+    std::mutex recorderMutex; // The destructor drops it while frames may still arrive;
+                              // taken after policyMutex when both are needed
+
+    // Pending policy for the processing thread, picked up in frameComplete
+    std::mutex policyMutex;
+    ThreadPolicy processingPolicy;
+    ThreadPolicy recorderPolicy;
+    bool recorderPolicySet = false;
+    bool memoryLocked = false;
+    int processingPolicyResult = 0;
+    std::atomic<unsigned int> policyGeneration{0};
+    unsigned int appliedGeneration = 0; // Only touched on the processing thread
+
+    int prefaultScratch();
+    int setSliceLayout(const SliceLayout &layout);
+    void applyProcessingPolicy();
+    void frameComplete(const FrameSource::Frame &frame);
+    bool recordFrame(const FrameSource::Frame &frame);
+    void renderFrame(cv::Mat &frame, const FrameSource::Frame &source);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,39 @@
+#include "CropGeometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BandCrop planBandCrop(const CropRect &maxCrop, uint32_t outputWidth, uint32_t outputHeight,
+                        double bandTop, double bandHeight) {
+    // The uncropped frame's area on the sensor
+    CropRect full = maxCrop;
+    if (static_cast<uint64_t>(maxCrop.width) * outputHeight > static_cast<uint64_t>(maxCrop.height) * outputWidth) {
+        full.width = static_cast<uint32_t>(static_cast<uint64_t>(maxCrop.height) * outputWidth / outputHeight);
+    } else {
+        full.height = static_cast<uint32_t>(static_cast<uint64_t>(maxCrop.width) * outputHeight / outputWidth);
+    }
+    full.x = maxCrop.x + static_cast<int>((maxCrop.width - full.width) / 2);
+    full.y = maxCrop.y + static_cast<int>((maxCrop.height - full.height) / 2);
+
+    // Band rows in the output, widened to even boundaries
+    bandTop = std::clamp(bandTop, 0.0, 1.0);
+    bandHeight = std::clamp(bandHeight, 0.0, 1.0 - bandTop);
+    int top = static_cast<int>(std::floor(bandTop * outputHeight)) & ~1;
+    int bottom = static_cast<int>(std::ceil((bandTop + bandHeight) * outputHeight));
+    bottom = std::min<int>(outputHeight, (bottom + 1) & ~1);
+    if (bottom - top < 2) {
+        top = std::max(0, std::min<int>(top, outputHeight - 2));
+        bottom = std::min<int>(outputHeight, top + 2);
+    }
+
+    // Same rows on the sensor
+    const double scale = static_cast<double>(full.height) / outputHeight;
+    BandCrop crop;
+    crop.scalerCrop.x = full.x;
+    crop.scalerCrop.width = full.width;
+    crop.scalerCrop.y = full.y + (static_cast<int>(std::lround(top * scale)) & ~1);
+    crop.scalerCrop.height = static_cast<uint32_t>(std::lround((bottom - top) * scale)) & ~1u;
+    crop.outputHeight = static_cast<uint32_t>(bottom - top);
+    crop.rowOffset = static_cast<uint32_t>(top);
+    return crop;
+}
@@ -0,0 +1,28 @@
+#ifndef _CROP_GEOMETRY_HPP_
+#define _CROP_GEOMETRY_HPP_
+
+#include <cstdint>
+
+// Rectangle on the sensor's pixel array (libcamera::Rectangle without the dependency)
+struct CropRect {
+    int x = 0;
+    int y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+struct BandCrop {
+    CropRect scalerCrop;    // ScalerCrop to request
+    uint32_t outputHeight;  // Rows to configure the stream with; the width stays
+    uint32_t rowOffset;     // Row of the uncropped output frame the first delivered row is
+};
+
+// Reads out only rows [bandTop, bandTop + bandHeight) (shares of the frame) of an
+// outputWidth x outputHeight stream, at the scale the uncropped frame would have had.
+// maxCrop is the mode's ScalerCrop maximum; like the ISP's default, the uncropped frame
+// is the largest centred part of it with the output's aspect ratio. Rows are kept even
+// for the ISP's chroma subsampling.
+BandCrop planBandCrop(const CropRect &maxCrop, uint32_t outputWidth, uint32_t outputHeight,
+                        double bandTop, double bandHeight);
+
+#endif
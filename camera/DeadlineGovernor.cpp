@@ -0,0 +1,39 @@
+#include "DeadlineGovernor.hpp"
+
+DeadlineGovernor::DeadlineGovernor(uint64_t budgetNs, const Options &options)
+    : options(options), stats{ budgetNs, 0, 0, 0, 0, 0, 0 } {}
+
+int DeadlineGovernor::update(uint64_t elapsedNs) {
+    stats.frames++;
+    stats.lastNs = elapsedNs;
+
+    if (elapsedNs > stats.budgetNs) {
+        stats.misses++;
+        consecutiveFast = 0;
+        if (++consecutiveMisses >= options.missesToDegrade && stats.level < options.maxLevel) {
+            stats.level++;
+            stats.stepsDown++;
+            consecutiveMisses = 0;
+        }
+    } else if (elapsedNs < stats.budgetNs * options.headroom) {
+        consecutiveMisses = 0;
+        if (++consecutiveFast >= options.framesToRecover && stats.level > 0) {
+            stats.level--;
+            stats.stepsUp++;
+            consecutiveFast = 0;
+        }
+    } else {
+        // Made it, but without enough margin to risk more work
+        consecutiveMisses = 0;
+        consecutiveFast = 0;
+    }
+    return stats.level;
+}
+
+int DeadlineGovernor::getLevel() const {
+    return stats.level;
+}
+
+DeadlineGovernor::Stats DeadlineGovernor::getStats() const {
+    return stats;
+}
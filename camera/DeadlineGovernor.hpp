@@ -0,0 +1,43 @@
+#ifndef _DEADLINE_GOVERNOR_HPP_
+#define _DEADLINE_GOVERNOR_HPP_
+
+#include <cstdint>
+
+// Compares each frame's processing time with the frame interval and picks a
+// degradation level: one level down after repeated misses, one back up after a run
+// of frames with clear headroom. The levels themselves are up to the caller.
+class DeadlineGovernor {
+public:
+    struct Options {
+        int missesToDegrade = 3;   // Consecutive misses before stepping down
+        int framesToRecover = 60;  // Consecutive fast frames before stepping back up
+        double headroom = 0.6;     // "Fast" means under this share of the budget
+        int maxLevel = 4;
+    };
+
+    struct Stats {
+        uint64_t budgetNs;
+        uint64_t frames;
+        uint64_t misses;
+        uint64_t stepsDown;
+        uint64_t stepsUp;
+        uint64_t lastNs;
+        int level;
+    };
+
+    DeadlineGovernor(uint64_t budgetNs, const Options &options);
+
+    // Feed one frame's processing time; returns the level for the next frame
+    int update(uint64_t elapsedNs);
+
+    int getLevel() const;
+    Stats getStats() const;
+
+private:
+    Options options;
+    Stats stats;
+    int consecutiveMisses = 0;
+    int consecutiveFast = 0;
+};
+
+#endif
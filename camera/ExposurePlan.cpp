@@ -0,0 +1,51 @@
+#include "ExposurePlan.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template <typename T>
+static T clampKnown(T value, T low, T high) {
+    if (low > 0) {
+        value = std::max(value, low);
+    }
+    if (high > 0) {
+        value = std::min(value, high);
+    }
+    return value;
+}
+
+ControlPlan planControls(const ExposureSettings &settings, const SensorLimits &limits) {
+    ControlPlan plan;
+    if (settings.fps > 0) {
+        const int64_t durationUs = static_cast<int64_t>(std::llround(1e6 / settings.fps));
+        plan.frameDurationUs = clampKnown(durationUs, limits.minFrameDurationUs, limits.maxFrameDurationUs);
+    }
+
+    if (settings.exposureUs > 0) {
+        const int64_t maxExposureUs = (plan.frameDurationUs > 0 && limits.maxExposureUs > 0)
+            ? std::min(limits.maxExposureUs, plan.frameDurationUs)
+            : std::max(limits.maxExposureUs, plan.frameDurationUs);
+        plan.exposureUs = clampKnown(settings.exposureUs, limits.minExposureUs, maxExposureUs);
+    }
+    if (settings.analogueGain > 0) {
+        plan.analogueGain = clampKnown(settings.analogueGain, limits.minGain, limits.maxGain);
+    }
+
+    // With both fixed there is nothing left for AE, and nothing to lock later
+    plan.aeEnable = !(plan.exposureUs > 0 && plan.analogueGain > 0);
+    plan.lockWhenConverged = settings.lockWhenConverged && plan.aeEnable;
+    return plan;
+}
+
+ControlPlan lockedPlan(const ControlPlan &plan, int64_t exposureUs, float analogueGain,
+                        float redGain, float blueGain) {
+    ControlPlan locked = plan;
+    locked.aeEnable = false;
+    locked.awbEnable = false;
+    locked.lockWhenConverged = false;
+    locked.exposureUs = (plan.exposureUs > 0) ? plan.exposureUs : exposureUs;
+    locked.analogueGain = (plan.analogueGain > 0) ? plan.analogueGain : analogueGain;
+    locked.colourGains[0] = redGain;
+    locked.colourGains[1] = blueGain;
+    return locked;
+}
@@ -0,0 +1,46 @@
+#ifndef _EXPOSURE_PLAN_HPP_
+#define _EXPOSURE_PLAN_HPP_
+
+#include <cstdint>
+
+// What the application asks for. Leaving the frame rate to AE lets it stretch frames in
+// the dark; fixing it keeps the interval constant and caps exposure at that interval.
+struct ExposureSettings {
+    double fps = 0;                 // Fixed frame rate; 0 = the sensor's default timing
+    int64_t exposureUs = 0;         // Fixed shutter; 0 = automatic (AE then only adjusts gain if fixed)
+    float analogueGain = 0;         // Fixed gain; 0 = automatic
+    bool lockWhenConverged = false; // Freeze AE & AWB at their first converged values
+};
+
+// The sensor's control ranges; 0 = not reported, no clamping
+struct SensorLimits {
+    int64_t minFrameDurationUs = 0;
+    int64_t maxFrameDurationUs = 0;
+    int64_t minExposureUs = 0;
+    int64_t maxExposureUs = 0;
+    float minGain = 0;
+    float maxGain = 0;
+};
+
+// Controls to send; zero fields are left alone
+struct ControlPlan {
+    int64_t frameDurationUs = 0; // Both FrameDurationLimits
+    int64_t exposureUs = 0;
+    float analogueGain = 0;
+    bool aeEnable = true;
+    bool awbEnable = true;
+    float colourGains[2] = { 0, 0 }; // Red & blue, when AWB is off
+    bool lockWhenConverged = false;
+};
+
+// Clamps the request to the sensor: the frame duration to its range, and exposure to
+// both its range and the frame duration so a fixed shutter can't stretch the interval.
+// No hardware involved, so configurations can be checked offline.
+ControlPlan planControls(const ExposureSettings &settings, const SensorLimits &limits);
+
+// The plan after AE/AWB converged on the given values: both off, their results fixed,
+// frame duration unchanged
+ControlPlan lockedPlan(const ControlPlan &plan, int64_t exposureUs, float analogueGain,
+                        float redGain, float blueGain);
+
+#endif
@@ -0,0 +1,215 @@
+#include "FakeFrameSource.hpp"
+#include "CropGeometry.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>   // close & ftruncate
+#include <sys/mman.h> // memfd_create, mmap & munmap
+
+static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+FakeFrameSource::FakeFrameSource(const Options &options) : options(options) {
+    // Reserved now so release never reallocates under the lock
+    stats.latenciesNs.reserve(options.latencySamples);
+}
+
+FakeFrameSource::~FakeFrameSource() {
+    stop();
+    freeAllBuffers();
+}
+
+int FakeFrameSource::configure(const uint_fast32_t width, const uint_fast32_t height,
+                                const PixelFormat pixelFormat, const StreamRole /*role*/) {
+    // The synthetic pattern is only rendered in the format FrameProcessor consumes
+    if (pixelFormat != libcamera::formats::XRGB8888 || options.bufferCount == 0) {
+        std::cerr << "Fake source only supports XRGB8888 with at least one buffer" << std::endl;
+        return -EINVAL;
+    }
+
+    freeAllBuffers();
+    format.width = width;
+    format.height = height;
+    format.stride = width * 4;
+    format.fourcc = pixelFormat.fourcc();
+    format.fullHeight = 0;
+    format.rowOffset = 0;
+
+    // A "sensor" exactly the size of the frame, so the crop is just a band of rows
+    if (bandHeight > 0 && bandHeight < 1) {
+        CropRect sensor;
+        sensor.width = width;
+        sensor.height = height;
+        const BandCrop crop = planBandCrop(sensor, width, height, bandTop, bandHeight);
+        format.height = crop.outputHeight;
+        format.fullHeight = height;
+        format.rowOffset = crop.rowOffset;
+    }
+
+    // memfd gives us real shared-memory fds, like dmabufs handed out by the ISP
+    const size_t bytes = static_cast<size_t>(format.stride) * format.height;
+    for (unsigned int i = 0; i < options.bufferCount; i++) {
+        int fd = memfd_create("fake-frame", MFD_CLOEXEC);
+        void* data_ = MAP_FAILED;
+        if (fd >= 0 && ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+            data_ = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (data_ == MAP_FAILED) {
+            // Nothing half-built survives a failed configure
+            const int error = errno;
+            std::cerr << "Failed to create fake frame buffer: " << std::strerror(error) << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            freeAllBuffers();
+            return -error;
+        }
+
+        buffers.push_back({ fd, static_cast<uint8_t*>(data_), bytes, 0 });
+        renderPattern(buffers.back(), i);
+        freeBuffers.push(i);
+    }
+    std::cout << "Allocated " << buffers.size() << " fake buffers for stream" << std::endl;
+
+    return 0;
+}
+
+const FrameSource::Format& FakeFrameSource::getFormat() const {
+    return format;
+}
+
+const FrameSource::Format& FakeFrameSource::getRecordingFormat() const {
+    return recordingFormat;
+}
+
+void FakeFrameSource::setBufferCount(unsigned int count) {
+    if (count > 0) {
+        options.bufferCount = count;
+    }
+}
+
+void FakeFrameSource::setExposure(const ExposureSettings &settings) {
+    if (settings.fps > 0) {
+        options.fps = settings.fps;
+    }
+    fixedExposureUs = settings.exposureUs;
+}
+
+void FakeFrameSource::setBandOfInterest(double top, double height) {
+    bandTop = top;
+    bandHeight = height;
+}
+
+void FakeFrameSource::start(FrameCallback onFrame) {
+    frameCallback = std::move(onFrame);
+    running = true;
+    completion = std::thread(&FakeFrameSource::completionLoop, this);
+}
+
+void FakeFrameSource::stop() {
+    running = false;
+    if (completion.joinable()) {
+        completion.join();
+    }
+}
+
+void FakeFrameSource::release(const Frame &frame) {
+    const size_t index = static_cast<size_t>(frame.cookie);
+    const uint64_t latency = nowNs() - buffers[index].completedNs;
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (stats.latenciesNs.size() < options.latencySamples) {
+        stats.latenciesNs.push_back(latency);
+    } else if (options.latencySamples > 0) {
+        stats.latenciesNs[nextLatency] = latency;
+        nextLatency = (nextLatency + 1) % options.latencySamples;
+    }
+    freeBuffers.push(index);
+}
+
+FakeFrameSource::Stats FakeFrameSource::getStats() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return stats;
+}
+
+void FakeFrameSource::completionLoop() {
+    using Clock = std::chrono::steady_clock;
+
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int64_t> jitter(-static_cast<int64_t>(options.jitterUs),
+                                                    static_cast<int64_t>(options.jitterUs));
+
+    const auto interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / options.fps));
+    Clock::time_point nextFrame = Clock::now() + interval;
+    uint64_t sequence = 0;
+
+    while (running) {
+        const Clock::time_point due = nextFrame + std::chrono::microseconds(jitter(random));
+        std::this_thread::sleep_until(due);
+        nextFrame += interval;
+        sequence++;
+
+        if (chance(random) < options.dropRate) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stats.simulatedDrops++;
+            continue;
+        }
+
+        // Like the real sensor, a frame with no queued buffer is simply lost
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (freeBuffers.empty()) {
+                stats.underruns++;
+                continue;
+            }
+            index = freeBuffers.front();
+            freeBuffers.pop();
+            stats.delivered++;
+            stats.maxInFlight = std::max<unsigned int>(stats.maxInFlight,
+                                                        buffers.size() - freeBuffers.size());
+        }
+
+        Buffer &buffer = buffers[index];
+        // Stamped when the "sensor" finished, so a late wake-up counts as latency too
+        buffer.completedNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count());
+
+        Frame frame;
+        frame.data = buffer.data;
+        frame.bytes = buffer.bytes;
+        frame.sequence = sequence;
+        frame.timestampNs = buffer.completedNs;
+        frame.exposureUs = (fixedExposureUs > 0) ? fixedExposureUs : static_cast<int64_t>(1e6 / options.fps);
+        frame.cookie = index;
+        frame.stream = 0;
+        frame.recording = nullptr;
+        frameCallback(frame);
+    }
+}
+
+void FakeFrameSource::renderPattern(Buffer &buffer, size_t index) {
+    // Light floor with a dark tape band that shifts a little between buffers
+    std::memset(buffer.data, 185, buffer.bytes);
+    const uint32_t tapeWidth = std::max<uint32_t>(format.width / 16, 2);
+    const uint32_t tapeStart = format.width / 2 - tapeWidth / 2 + (index % 5) * tapeWidth / 4;
+
+    for (uint32_t y = 0; y < format.height; y++) {
+        uint8_t* row = buffer.data + static_cast<size_t>(y) * format.stride;
+        uint32_t end = std::min(format.width, tapeStart + tapeWidth);
+        std::memset(row + tapeStart * 4, 40, (end - tapeStart) * 4);
+    }
+}
+
+void FakeFrameSource::freeAllBuffers() {
+    for (Buffer &buffer : buffers) {
+        munmap(buffer.data, buffer.bytes);
+        close(buffer.fd);
+    }
+    buffers.clear();
+    freeBuffers = std::queue<size_t>();
+}
@@ -0,0 +1,83 @@
+#ifndef _FAKE_FRAME_SOURCE_HPP_
+#define _FAKE_FRAME_SOURCE_HPP_
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FrameSource.hpp"
+
+// In-process stand-in for the camera. Frames live in memfd-backed buffers and are
+// completed on a background thread at a configurable rate with jitter & drops, so
+// the request/recycle flow can be stress-tested without a sensor.
+class FakeFrameSource : public FrameSource {
+public:
+    struct Options {
+        double fps = 30.0;
+        uint32_t jitterUs = 0;    // Uniform +/- jitter on each frame interval
+        double dropRate = 0.0;    // Probability a frame is lost on the "sensor"
+        unsigned int bufferCount = 4;
+        uint32_t seed = 1;
+        size_t latencySamples = 1 << 16; // Most recent latencies kept, allocated up front
+    };
+
+    struct Stats {
+        uint64_t delivered = 0;
+        uint64_t simulatedDrops = 0;
+        uint64_t underruns = 0;   // Frame due but every buffer was still held by the consumer
+        unsigned int maxInFlight = 0;
+        std::vector<uint64_t> latenciesNs; // Completion to release, last latencySamples frames (unordered)
+    };
+
+    explicit FakeFrameSource(const Options &options);
+    ~FakeFrameSource() override;
+
+    int configure(const uint_fast32_t width, const uint_fast32_t height,
+                    const PixelFormat pixelFormat, const StreamRole role) override;
+    const Format& getFormat() const override;
+    const Format& getRecordingFormat() const override;
+    void setBufferCount(unsigned int count) override;
+    void setExposure(const ExposureSettings &settings) override;
+    void setBandOfInterest(double top, double height) override;
+    void start(FrameCallback onFrame) override;
+    void stop() override;
+    void release(const Frame &frame) override;
+
+    Stats getStats() const;
+
+private:
+    struct Buffer {
+        int fd;
+        uint8_t* data;
+        size_t bytes;
+        uint64_t completedNs;
+    };
+
+    Options options;
+    int64_t fixedExposureUs = 0; // Reported instead of the frame interval when set
+    double bandTop = 0;          // Rows to deliver, cut like the ISP would
+    double bandHeight = 0;
+    Format format;
+    Format recordingFormat; // Always empty: one stream only
+    std::vector<Buffer> buffers;
+    FrameCallback frameCallback;
+
+    std::thread completion;
+    std::atomic<bool> running{false};
+
+    // Buffers the consumer handed back, ready to be "exposed" again
+    mutable std::mutex stateMutex;
+    std::queue<size_t> freeBuffers;
+    Stats stats;
+    size_t nextLatency = 0; // Ring slot to overwrite once latenciesNs is full
+
+    void completionLoop();
+    void renderPattern(Buffer &buffer, size_t index);
+    void freeAllBuffers();
+};
+
+#endif
@@ -1,4 +1,23 @@
 #include "FrameProcessor.hpp"
+#include "GrayKernels.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <sys/resource.h> // getrusage
+
+// A line this much darker than its surroundings (share of full scale) scores full contrast
+static constexpr double FULL_CONTRAST = 0.25;
+
+// Blobs covering more of the slice than this are more likely shadows than tape
+static constexpr double MAX_LINE_FRACTION = 0.5;
+
+// Page faults taken by the calling thread so far
+static void threadFaults(uint64_t &minor, uint64_t &major) {
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    minor = static_cast<uint64_t>(usage.ru_minflt);
+    major = static_cast<uint64_t>(usage.ru_majflt);
+}
 
 FrameProcessor::FrameProcessor(int numOfSlices, double meanIntensityMult,
                                int minThreshold, int maxThreshold, bool debug)
@@ -7,43 +26,120 @@ FrameProcessor::FrameProcessor(int numOfSlices, double meanIntensityMult,
       minThreshold(minThreshold),
       maxThreshold(maxThreshold),
       debugMode(debug) {
-    // Allocate the return distance array
+    // Allocate the return distance arrays
     distances = new int[slices]{};
+    distancesPx = new float[slices]{};
+    distancesNorm = new float[slices]{};
+
+    candidates.assign(slices, SliceCandidates{});
+    statuses.assign(slices, SliceStatus{});
+    groundPoints.assign(slices, GroundPoint{});
+    sliceSums.resize(slices);
+    sliceThresholds.assign(slices, -1);
+    dueSlices.assign(slices, 1);
+    history = std::make_unique<ResultHistory>(128);
 }
 
 FrameProcessor::~FrameProcessor() {
     delete[] distances;
-    cv::destroyWindow("Camera Feed");
+    delete[] distancesPx;
+    delete[] distancesNorm;
+    if (debugMode) {
+        cv::destroyWindow("Camera Feed");
+    }
 }
 
 void FrameProcessor::processFrame(cv::Mat &frame, unsigned int height, unsigned int width,
-                    const uint8_t* buffer) {
-    // Create an OpenCV Mat from the mapped buffer
-    frame = cv::Mat(height, width, CV_8UC4, const_cast<uint8_t*>(buffer));
+                    const uint8_t* buffer, uint64_t sequence, uint64_t timestampNs) {
+    const auto started = std::chrono::steady_clock::now();
+    uint64_t minorBefore, majorBefore;
+    threadFaults(minorBefore, majorBefore);
+    frameSequence = sequence;
+    const int pending = pendingLevel.exchange(-1, std::memory_order_acquire);
+    if (pending >= 0) {
+        applyLevel(static_cast<DegradationLevel>(pending));
+    }
+    // imshow can't display packed 4:2:2, so YUYV runs without the preview
+    drawOverlay = debugMode && level < DegradationLevel::NoOverlay && inputFormat->fourcc != FOURCC_YUYV;
+
+    // Create an OpenCV Mat from the mapped buffer (plane 0 only for planar formats)
+    frame = cv::Mat(height, width, CV_8UC(inputFormat->bytesPerPixel), const_cast<uint8_t*>(buffer),
+                    inputStride ? inputStride : static_cast<size_t>(cv::Mat::AUTO_STEP));
+    if (frame.size() != geometrySize) {
+        prepareGeometry(frame.size());
+    }
+
+    // Coarse-to-fine only ever converts a decimated copy of the whole frame; the full
+    // resolution path converts & blurs everything up front. When the schedule skips
+    // slices only the due ones are converted.
+    const bool gatherStats = thresholdMode != ThresholdMode::RegionMean;
+    uint32_t* histograms = (thresholdMode == ThresholdMode::Otsu) ? sliceHistograms.data() : nullptr;
+    if (updateDueSlices() < visibleSlices) {
+        for (int i = 0; i < slices; i++) {
+            if (dueSlices[i]) {
+                convertSlice(frame, i, gatherStats, histograms);
+            }
+        }
+    } else if (pyramidFactor > 1) {
+        inputFormat->decimateToGray(buffer, frame.step, width, height, pyramidFactor, gray.data, gray.step);
+        if (gatherStats) {
+            grayBandStats(gray.data, gray.step, gray.cols, gray.rows, rowBands.data(), slices,
+                            sliceSums.data(), histograms);
+        }
+    } else if (inputFormat->inPlace) {
+        // The Y plane already is the gray image; the blur is the only pass over it
+        if (gatherStats) {
+            grayBandStats(frame.data, frame.step, width, height, rowBands.data(), slices,
+                            sliceSums.data(), histograms);
+        }
+        cv::GaussianBlur(frame, gray, cv::Size(5, 5), 0);
+    } else {
+        // Convert to grayscale, summing each slice on the way so thresholds cost no extra pass
+        if (specializedKernel) {
+            specializedKernel(buffer, frame.step, gray.data, gray.step, sliceSums.data(), histograms);
+        } else {
+            inputFormat->toGrayWithStats(buffer, frame.step, width, height, gray.data, gray.step,
+                                            gatherStats ? rowBands.data() : nullptr, slices,
+                                            sliceSums.data(), histograms);
+        }
+
+        // Preprocess the grayscale image: Gaussian blur to reduce noise (keeps slice means)
+        cv::GaussianBlur(gray, gray, cv::Size(5, 5), 0);
+    }
+    updateSliceThresholds();
 
-    // Convert to grayscale
-    cv::Mat gray;
-    cv::cvtColor(frame, gray, cv::COLOR_BGRA2GRAY);
+    // The tracker needs the searched width, which is only known once frames arrive
+    if (trackingEnabled && !tracker) {
+        tracker = std::make_unique<SliceTracker>(slices, gray.cols, trackerOptions);
+    }
 
-    // Preprocess the grayscale image: Gaussian blur to reduce noise
-    cv::GaussianBlur(gray, gray, cv::Size(5, 5), 0);
+    contourCenters.clear(); // To store the centers of the contours
 
-    int sliceHeight = gray.rows / slices;
-    std::vector<cv::Point> contourCenters; // To store the centers of the contours
-    
     for (int i = 0; i < slices; i++) {
-        int startY = i * sliceHeight;
-        cv::Rect sliceROI(0, startY, gray.cols, sliceHeight);
-        cv::Mat slice = gray(sliceROI);
+        if (!dueSlices[i]) {
+            std::lock_guard<std::mutex> lock(distancesMutex);
+            statuses[i].refreshed = 0;
+            if (!geometry[i].visible) {
+                // Outside the delivered rows: there is nothing to carry over either
+                statuses[i].present = 0;
+                statuses[i].confidence = 0;
+                candidates[i].count = 0;
+                groundPoints[i].valid = 0;
+            }
+            continue;
+        }
+        cv::Mat slice = gray(geometry[i].grayROI);
 
         // Process each slice and get the contour center
-        cv::Point contourCenter = processSlice(slice, i, frame, sliceHeight);
+        cv::Point contourCenter = (pyramidFactor > 1)
+            ? processSlicePyramid(slice, i, frame)
+            : processSlice(slice, i, frame);
         contourCenters.push_back(contourCenter);
 
-        if (debugMode) {
+        if (drawOverlay) {
             // Draw red slice center dot
-            int sliceMiddleX = slice.cols / 2;
-            int sliceMiddleY = sliceHeight / 2 + startY;
+            int sliceMiddleX = frame.cols / 2;
+            int sliceMiddleY = static_cast<int>(geometry[i].centerRow);
             cv::circle(frame, cv::Point(sliceMiddleX, sliceMiddleY), 5, cv::Scalar(0, 0, 255), -1);
 
             // Draw pink line connecting the white dot to the red dot
@@ -51,7 +147,10 @@ void FrameProcessor::processFrame(cv::Mat &frame, unsigned int height, unsigned
         }
     }
 
-    if (debugMode) {
+    // Published before any drawing so readers see it as early as possible
+    publishHistory(timestampNs);
+
+    if (drawOverlay) {
         // Draw blue lines connecting all white dots
         for (size_t i = 1; i < contourCenters.size(); ++i) {
             cv::line(frame, contourCenters[i - 1], contourCenters[i], cv::Scalar(255, 0, 0), 2, cv::LINE_8, 0);
@@ -63,67 +162,597 @@ void FrameProcessor::processFrame(cv::Mat &frame, unsigned int height, unsigned
         }
     }
 
-    // Display the processed result
-    cv::imshow("Camera Feed", frame);
-    cv::waitKey(1);
+    // Display the processed result (headless runs such as replays skip the window)
+    if (drawOverlay) {
+        cv::imshow("Camera Feed", frame);
+        cv::waitKey(1);
+    }
+
+    // Degrade or recover for the next frame based on how long this one took
+    {
+        const uint64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        int next = -1;
+        {
+            std::lock_guard<std::mutex> lock(deadlinesMutex);
+            if (deadlines) {
+                next = deadlines->update(elapsedNs);
+            }
+        }
+        if (next >= 0 && next != static_cast<int>(level)) {
+            applyLevel(static_cast<DegradationLevel>(next));
+        }
+    }
+
+    uint64_t minorAfter, majorAfter;
+    threadFaults(minorAfter, majorAfter);
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        memoryStats.frames++;
+        memoryStats.lastMinorFaults = minorAfter - minorBefore;
+        memoryStats.lastMajorFaults = majorAfter - majorBefore;
+        memoryStats.minorFaults += memoryStats.lastMinorFaults;
+        memoryStats.majorFaults += memoryStats.lastMajorFaults;
+    }
 }
 
-cv::Point FrameProcessor::processSlice(cv::Mat &slice, int sliceIndex, cv::Mat &frame,
-                                        int sliceHeight) {
-    // Apply threshold & morphological closing to clean up noise and fill small gaps
-    cv::Mat thresh;
-    int thresholdValue = std::clamp(static_cast<int>(cv::mean(slice)[0] * meanIntensityMult), minThreshold, maxThreshold);
-    cv::threshold(slice, thresh, thresholdValue, 255, cv::THRESH_BINARY_INV);
-    cv::morphologyEx(thresh, thresh, cv::MORPH_CLOSE, cv::Mat(), cv::Point(-1, -1), 2);
+void FrameProcessor::publishHistory(uint64_t timestampNs) {
+    // Only this thread writes the slice results, so they're read here without the lock
+    LineHistoryRecord record{};
+    record.sequence = frameSequence;
+    record.timestampNs = timestampNs ? timestampNs : static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    record.slices = std::min(slices, LINE_HISTORY_MAX_SLICES);
+    for (int i = 0; i < record.slices; i++) {
+        record.presentMask |= static_cast<uint32_t>(statuses[i].present != 0) << i;
+        record.refreshedMask |= static_cast<uint32_t>(statuses[i].refreshed != 0) << i;
+        record.distances[i] = distancesPx[i];
+        record.confidence[i] = statuses[i].confidence;
+    }
+    // A skipped slice's present flag belongs to an earlier frame
+    record.presentMask &= record.refreshedMask;
+    history->publish(record);
+}
 
-    // Find contours
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(thresh, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+void FrameProcessor::prepareGeometry(const cv::Size &frameSize) {
+    const int fullHeight = (windowFullHeight > 0) ? windowFullHeight : frameSize.height;
+    const SliceLayout uncropped = sliceLayout.empty() ? SliceLayout() : sliceLayout.scaledTo(fullHeight);
+    const SliceLayout layout = sliceLayout.empty()
+        ? SliceLayout::uniform(frameSize.height, slices)
+        : uncropped.croppedTo(windowOffset, frameSize.height);
+    const int grayWidth = frameSize.width / pyramidFactor;
+    const int grayHeight = frameSize.height / pyramidFactor;
 
-    // No contours found; return the center of the slice for continuity
-    if (contours.empty()) {
-        return cv::Point(slice.cols / 2, sliceHeight / 2 + sliceIndex * sliceHeight);
+    geometry.resize(slices);
+    rowBands.assign(grayHeight, -1);
+    visibleSlices = 0;
+    std::vector<double> centerRows(slices);
+    for (int i = 0; i < slices; i++) {
+        SliceGeometry &slice = geometry[i];
+        slice.rows = layout[i];
+        slice.visible = !slice.rows.empty();
+
+        // Slices outside the window are never searched; the tables still get their real row
+        if (!slice.visible) {
+            slice.centerRow = (uncropped[i].start + uncropped[i].end) / 2.0 - windowOffset;
+            centerRows[i] = slice.centerRow + windowOffset;
+            slice.grayROI = cv::Rect(0, 0, grayWidth, 0);
+            slice.bandPixels = 0;
+            continue;
+        }
+        visibleSlices++;
+        slice.centerRow = (slice.rows.start + slice.rows.end) / 2.0;
+        centerRows[i] = slice.centerRow + windowOffset;
+
+        const int grayStart = std::min(slice.rows.start / pyramidFactor, grayHeight - 1);
+        const int grayEnd = std::clamp(slice.rows.end / pyramidFactor, grayStart + 1, grayHeight);
+        slice.grayROI = cv::Rect(0, grayStart, grayWidth, grayEnd - grayStart);
+        slice.bandPixels = slice.grayROI.area();
+        std::fill(rowBands.begin() + grayStart, rowBands.begin() + grayEnd, i);
     }
 
-    // Find the largest contour
-    auto mainContour = *std::max_element(contours.begin(), contours.end(),
-        [](const std::vector<cv::Point> &a, const std::vector<cv::Point> &b) {
-            return cv::contourArea(a) < cv::contourArea(b);
+    // Prebuilt kernels bake in an even split of the whole frame
+    specializedKernel = sliceLayout.empty()
+        ? findSpecializedKernel(frameSize.width, frameSize.height, slices, inputFormat->fourcc)
+        : nullptr;
+
+    // Centroids are reported on each slice's middle row; tabulate those rows (in the
+    // uncropped frame the calibrations were made on)
+    if (lensModel) {
+        lensModel->prepare(frameSize.width, fullHeight, centerRows);
+    }
+    if (groundMapper) {
+        groundMapper->prepare(frameSize.width, fullHeight, centerRows, lensModel.get());
+    }
+
+    int tallestSlice = 0;
+    for (const SliceGeometry &slice : geometry) {
+        tallestSlice = std::max(tallestSlice, slice.grayROI.height);
+    }
+    loneBandRows.assign(tallestSlice, 0);
+
+    int tallestFrameSlice = 0;
+    for (const SliceGeometry &slice : geometry) {
+        tallestFrameSlice = std::max(tallestFrameSlice, slice.rows.end - slice.rows.start);
+    }
+    layoutArena(frameSize, tallestFrameSlice);
+
+    contourCenters.reserve(slices);
+    geometrySize = frameSize;
+}
+
+void FrameProcessor::layoutArena(const cv::Size &frameSize, int tallestFrameSlice) {
+    // Sized for the requested pyramid level: degrading only ever searches a coarser,
+    // smaller copy, so stepping down & back up reuses the same arena
+    const int fullWidth = frameSize.width / requestedPyramidFactor;
+    const int fullHeight = frameSize.height / requestedPyramidFactor;
+    const int sliceRows = std::min(fullHeight, tallestFrameSlice / requestedPyramidFactor + 2);
+
+    const size_t grayBytes = ScratchArena::align(static_cast<size_t>(fullWidth) * fullHeight);
+    const size_t stripBytes = ScratchArena::align(static_cast<size_t>(tallestFrameSlice) * 2 * refineHalfWidth);
+    const size_t threshBytes = std::max(ScratchArena::align(static_cast<size_t>(fullWidth) * sliceRows),
+                                        stripBytes);
+
+    // gray | unblurred | strip | thresh
+    const size_t unblurredOffset = grayBytes;
+    const size_t stripOffset = unblurredOffset + grayBytes;
+    const size_t threshOffset = stripOffset + stripBytes;
+    const size_t total = threshOffset + threshBytes;
+
+    if (!arena || arena->size() < total) {
+        arena = std::make_unique<ScratchArena>(total, hugePages);
+
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        memoryStats.arenaBytes = arena->size();
+        memoryStats.hugePages = arena->hugePagesAdvised();
+    }
+
+    const int grayWidth = frameSize.width / pyramidFactor;
+    const int grayHeight = frameSize.height / pyramidFactor;
+    gray = cv::Mat(grayHeight, grayWidth, CV_8UC1, arena->at(0));
+    unblurred = cv::Mat(grayHeight, grayWidth, CV_8UC1, arena->at(unblurredOffset));
+    strip = cv::Mat();
+    stripData = arena->at(stripOffset);
+    threshData = arena->at(threshOffset);
+}
+
+void FrameProcessor::prefault(const cv::Size &frameSize) {
+    prepareGeometry(frameSize);
+}
+
+void FrameProcessor::setHugePages(bool enabled) {
+    hugePages = enabled;
+    arena.reset();
+    gray = cv::Mat();
+    unblurred = cv::Mat();
+    strip = cv::Mat();
+    geometrySize = cv::Size();
+}
+
+FrameProcessor::MemoryStats FrameProcessor::getMemoryStats() const {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return memoryStats;
+}
+
+int FrameProcessor::updateDueSlices() {
+    std::lock_guard<std::mutex> lock(scheduleMutex);
+
+    int due = 0;
+    for (int i = 0; i < slices; i++) {
+        dueSlices[i] = geometry[i].visible && schedule.isDue(i, processedFrames) &&
+            (level < DegradationLevel::ReducedSlices || (processedFrames + i) % 2 == 0);
+        due += dueSlices[i];
+    }
+    processedFrames++;
+    return due;
+}
+
+void FrameProcessor::convertSlice(const cv::Mat &frame, int sliceIndex, bool gatherStats,
+                                    uint32_t* histograms) {
+    const cv::Rect &roi = geometry[sliceIndex].grayROI;
+    if (pyramidFactor > 1) {
+        inputFormat->decimateToGray(frame.ptr(roi.y * pyramidFactor), frame.step, frame.cols,
+                                    roi.height * pyramidFactor, pyramidFactor, gray.ptr(roi.y), gray.step);
+        if (gatherStats) {
+            grayBandStats(gray.ptr(roi.y), gray.step, roi.width, roi.height, loneBandRows.data(), 1,
+                            &sliceSums[sliceIndex], histograms ? histograms + sliceIndex * 256 : nullptr);
         }
-    );
+        return;
+    }
 
-    // Calculate the center of the largest contour
-    cv::Moments M = cv::moments(mainContour);
-    int contourCenterX = (M.m00 != 0) ? static_cast<int>(M.m10 / M.m00) : slice.cols / 2;
+    // Luma is its own unblurred copy; the blur reads the neighbouring rows straight from it
+    cv::Mat graySlice = gray(roi);
+    if (inputFormat->inPlace) {
+        if (gatherStats) {
+            grayBandStats(frame.ptr(roi.y), frame.step, roi.width, roi.height, loneBandRows.data(), 1,
+                            &sliceSums[sliceIndex], histograms ? histograms + sliceIndex * 256 : nullptr);
+        }
+        cv::GaussianBlur(frame(roi), graySlice, cv::Size(5, 5), 0);
+        return;
+    }
+
+    // The blur reads two rows past either edge, so convert those as well. It reads from a
+    // separate image so a neighbouring slice's blurred rows are never blurred twice.
+    cv::Rect band = cv::Rect(0, roi.y - 2, roi.width, roi.height + 4) & cv::Rect(0, 0, gray.cols, gray.rows);
+    inputFormat->toGrayWithStats(frame.ptr(band.y), frame.step, band.width, band.height,
+                                    unblurred.ptr(band.y), unblurred.step, nullptr, 0, nullptr, nullptr);
+
+    if (gatherStats) {
+        grayBandStats(unblurred.ptr(roi.y), unblurred.step, roi.width, roi.height, loneBandRows.data(), 1,
+                        &sliceSums[sliceIndex], histograms ? histograms + sliceIndex * 256 : nullptr);
+    }
+
+    cv::GaussianBlur(unblurred(roi), graySlice, cv::Size(5, 5), 0);
+}
+
+cv::Point FrameProcessor::processSlice(cv::Mat &slice, int sliceIndex, cv::Mat &frame) {
+    SliceHit hit = searchSlice(slice, sliceIndex);
+    return publishSlice(hit, sliceIndex, frame);
+}
+
+cv::Point FrameProcessor::processSlicePyramid(cv::Mat &coarseSlice, int sliceIndex, cv::Mat &frame) {
+    SliceHit coarse = searchSlice(coarseSlice, sliceIndex);
+    if (!coarse.found) {
+        return publishSlice(coarse, sliceIndex, frame);
+    }
+
+    // Candidates come from the coarse level, scaled to full resolution
+    const int factor = pyramidFactor;
+    for (int i = 0; i < coarse.blobCount; i++) {
+        Blob &blob = coarse.blobs[i];
+        blob.centerX = blob.centerX * factor + (factor - 1) / 2.0;
+        blob.width *= factor;
+        blob.area *= factor * factor;
+    }
+
+    // Only a narrow full resolution strip around the coarse hit is converted & searched
+    const int coarseCenterX = static_cast<int>(coarse.centerX * factor + (factor - 1) / 2.0);
+    const int startX = std::max(0, coarseCenterX - refineHalfWidth);
+    const int endX = std::min(frame.cols, coarseCenterX + refineHalfWidth);
+    const cv::Range &rows = geometry[sliceIndex].rows;
+    cv::Rect stripROI(startX, rows.start, endX - startX, rows.end - rows.start);
+
+    // A header over the arena: strip widths vary, allocations shouldn't
+    strip = cv::Mat(stripROI.height, stripROI.width, CV_8UC1, stripData);
+
+    if (inputFormat->inPlace) {
+        cv::GaussianBlur(frame(stripROI), strip, cv::Size(5, 5), 0);
+    } else {
+        inputFormat->toGrayWithStats(frame.ptr(stripROI.y) + stripROI.x * inputFormat->bytesPerPixel,
+                                        frame.step, stripROI.width, stripROI.height, strip.data, strip.step,
+                                        nullptr, 0, nullptr, nullptr);
+        cv::GaussianBlur(strip, strip, cv::Size(5, 5), 0);
+    }
+
+    // Threshold from the whole (coarse) slice so the strip's own dark share doesn't skew it
+    SliceHit hit;
+    const int thresholdValue = (sliceThresholds[sliceIndex] >= 0) ? sliceThresholds[sliceIndex]
+                                                                   : thresholdFor(coarseSlice);
+    findLine(strip, cv::Range(0, strip.cols), hit, thresholdValue);
+    bool clipped = hit.found && ((hit.bounds.x == 0 && startX > 0) ||
+                    (hit.bounds.x + hit.bounds.width >= strip.cols && endX < frame.cols));
+
+    // The line is wider than the strip or vanished at full resolution; keep the coarse answer
+    if (!hit.found || clipped) {
+        coarse.centerX = coarse.blobs[0].centerX;
+        coarse.contour.clear();
+        return publishSlice(coarse, sliceIndex, frame);
+    }
+
+    hit.centerX += startX;
+    hit.offsetX += startX;
+
+    // Refined main blob replaces its coarse estimate; the other candidates stay coarse
+    std::copy(coarse.blobs + 1, coarse.blobs + coarse.blobCount, hit.blobs + 1);
+    hit.blobs[0].centerX = hit.centerX;
+    hit.blobCount = coarse.blobCount;
+    return publishSlice(hit, sliceIndex, frame);
+}
+
+FrameProcessor::SliceHit FrameProcessor::searchSlice(const cv::Mat &slice, int sliceIndex) {
+    // Search only around the predicted position while the track is confident, and fall
+    // back to the whole slice when the line left the window or was cut by its edge
+    SliceHit hit;
+    const cv::Range fullWidth(0, slice.cols);
+    cv::Range window = tracker ? tracker->searchWindow(sliceIndex, processedFrames) : fullWidth;
+    findLine(slice, window, hit, sliceThresholds[sliceIndex]);
+    if (window.start != fullWidth.start || window.end != fullWidth.end) {
+        if (!hit.found || hit.clipped) {
+            hit = SliceHit();
+            findLine(slice, fullWidth, hit, sliceThresholds[sliceIndex]);
+        }
+    }
+
+    if (tracker) {
+        tracker->update(sliceIndex, processedFrames, hit.found, hit.centerX);
+    }
+    return hit;
+}
+
+cv::Point FrameProcessor::publishSlice(const SliceHit &hit, int sliceIndex, cv::Mat &frame) {
+    const cv::Range &rows = geometry[sliceIndex].rows;
+    const int sliceTop = rows.start;
+    const int sliceHeight = rows.end - rows.start;
+
+    // No contours found; return the center of the slice for continuity
+    if (!hit.found) {
+        std::lock_guard<std::mutex> lock(distancesMutex);
+        candidates[sliceIndex].count = 0;
+        statuses[sliceIndex] = SliceStatus{ 0, 1, 0.0f, 0.0f, 0.0f, 0.0f, frameSequence };
+        groundPoints[sliceIndex].valid = 0;
+        return cv::Point(frame.cols / 2, sliceTop + sliceHeight / 2);
+    }
+
+    int contourCenterX = static_cast<int>(hit.centerX);
     int contourCenterY = sliceHeight / 2;
 
     // Calculate distance from the center of the slice to the contour's center
-    int sliceMiddleX = slice.cols / 2;
+    int sliceMiddleX = frame.cols / 2;
     int distance = sliceMiddleX - contourCenterX;
 
-    // Calculate extent of the contour
-    double extent = cv::contourArea(mainContour) / static_cast<double>(cv::boundingRect(mainContour).area());
+    // Sub-pixel distances, measured between undistorted positions when a lens is known
+    auto correctedDistance = [&](double x) {
+        if (!lensModel) {
+            return static_cast<float>(sliceMiddleX - x);
+        }
+        return lensModel->undistort(sliceIndex, sliceMiddleX).x - lensModel->undistort(sliceIndex, x).x;
+    };
+    float distancePx = correctedDistance(hit.centerX);
 
-    // Add the calculated distance to the return array
-    distances[sliceIndex] = distance;
+    // Trust thin, solid, high contrast blobs; shadows fill the slice & noise is faint
+    double areaFraction = hit.blobs[0].area / (static_cast<double>(frame.cols) * sliceHeight);
+    double contrastScore = std::min(1.0, hit.contrast / FULL_CONTRAST);
+    double sizeScore = (areaFraction <= MAX_LINE_FRACTION)
+        ? 1.0 : std::max(0.0, (1.0 - areaFraction) / (1.0 - MAX_LINE_FRACTION));
+    double confidence = std::clamp(hit.extent, 0.0, 1.0) * contrastScore * sizeScore;
 
-    if (debugMode) {
+    // Add the calculated distances to the return arrays
+    {
+        std::lock_guard<std::mutex> lock(distancesMutex);
+        distances[sliceIndex] = distance;
+        distancesPx[sliceIndex] = distancePx;
+        distancesNorm[sliceIndex] = std::clamp(distancePx / sliceMiddleX, -1.0f, 1.0f);
+
+        SliceCandidates &record = candidates[sliceIndex];
+        record.count = hit.blobCount;
+        for (int i = 0; i < hit.blobCount; i++) {
+            record.candidates[i].distance = correctedDistance(hit.blobs[i].centerX);
+            record.candidates[i].width = static_cast<float>(hit.blobs[i].width);
+            record.candidates[i].area = static_cast<float>(hit.blobs[i].area);
+            record.candidates[i].extent = static_cast<float>(hit.blobs[i].extent);
+        }
+
+        statuses[sliceIndex] = SliceStatus{ 1, 1, static_cast<float>(confidence),
+                                            static_cast<float>(hit.extent),
+                                            static_cast<float>(areaFraction),
+                                            static_cast<float>(hit.contrast), frameSequence };
+
+        if (groundMapper) {
+            cv::Point2f ground = groundMapper->map(sliceIndex, hit.centerX);
+            groundPoints[sliceIndex] = GroundPoint{ 1, ground.x, ground.y };
+        }
+    }
+
+    if (drawOverlay) {
         // Draw the green contour and white center dot
-        cv::Rect sliceROI(0, sliceIndex * sliceHeight, slice.cols, sliceHeight);
-        cv::drawContours(frame(sliceROI), std::vector<std::vector<cv::Point>>{mainContour}, -1, cv::Scalar(0, 255, 0), 2);
-        cv::circle(frame, cv::Point(contourCenterX, contourCenterY + sliceIndex * sliceHeight), 5, cv::Scalar(255, 255, 255), -1);
+        if (!hit.contour.empty()) {
+            cv::Rect sliceROI(hit.offsetX, sliceTop, hit.width, sliceHeight);
+            cv::drawContours(frame(sliceROI), std::vector<std::vector<cv::Point>>{hit.contour}, -1, cv::Scalar(0, 255, 0), 2);
+        }
+        cv::circle(frame, cv::Point(contourCenterX, contourCenterY + sliceTop), 5, cv::Scalar(255, 255, 255), -1);
 
         // Display the calculated distance and extent
         cv::putText(frame, "Dist: " + std::to_string(distance),
-                    cv::Point(contourCenterX + 20, contourCenterY + sliceIndex * sliceHeight - 10),
+                    cv::Point(contourCenterX + 20, contourCenterY + sliceTop - 10),
                     cv::FONT_HERSHEY_SIMPLEX, 1, cv::Scalar(200, 0, 200), 2);
-        cv::putText(frame, "Weight: " + std::to_string(extent),
-                    cv::Point(contourCenterX + 20, contourCenterY + sliceIndex * sliceHeight + 20),
+        cv::putText(frame, "Weight: " + std::to_string(hit.extent),
+                    cv::Point(contourCenterX + 20, contourCenterY + sliceTop + 20),
                     cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(200, 0, 200), 1);
     }
 
     // Return the center of the contour
-    return cv::Point(contourCenterX, contourCenterY + sliceIndex * sliceHeight);
+    return cv::Point(contourCenterX, contourCenterY + sliceTop);
+}
+
+void FrameProcessor::updateSliceThresholds() {
+    for (int i = 0; i < slices; i++) {
+        // A skipped slice's sums are left over from the last frame that evaluated it
+        if (!dueSlices[i]) {
+            continue;
+        }
+        const int bandPixels = geometry[i].bandPixels;
+        if (thresholdMode == ThresholdMode::RegionMean || bandPixels <= 0) {
+            sliceThresholds[i] = -1;
+            continue;
+        }
+
+        double mean = static_cast<double>(sliceSums[i]) / bandPixels;
+        int value;
+        if (thresholdMode == ThresholdMode::Otsu) {
+            value = otsuThreshold(&sliceHistograms[i * 256]);
+        } else if (thresholdMode == ThresholdMode::PreviousSliceMean && !previousSliceMeans.empty() &&
+                   previousSliceMeans[i] >= 0) {
+            value = static_cast<int>(previousSliceMeans[i] * meanIntensityMult);
+        } else {
+            value = static_cast<int>(mean * meanIntensityMult);
+        }
+        sliceThresholds[i] = std::clamp(value, minThreshold, maxThreshold);
+    }
+
+    // This frame's means become next frame's thresholds; slices skipped now have none, so
+    // they fall back to their own mean when next evaluated
+    if (thresholdMode == ThresholdMode::PreviousSliceMean) {
+        previousSliceMeans.resize(slices);
+        for (int i = 0; i < slices; i++) {
+            previousSliceMeans[i] = (dueSlices[i] && geometry[i].bandPixels > 0)
+                ? static_cast<double>(sliceSums[i]) / geometry[i].bandPixels : -1.0;
+        }
+    }
+}
+
+int FrameProcessor::thresholdFor(const cv::Mat &region) const {
+    return std::clamp(static_cast<int>(cv::mean(region)[0] * meanIntensityMult), minThreshold, maxThreshold);
+}
+
+void FrameProcessor::findLine(const cv::Mat &slice, const cv::Range &window, SliceHit &hit,
+                                int thresholdValue) {
+    cv::Mat region = slice.colRange(window.start, window.end);
+    hit.offsetX = window.start;
+    hit.width = region.cols;
+
+    // Apply threshold & morphological closing to clean up noise and fill small gaps
+    cv::Mat thresh(region.rows, region.cols, CV_8UC1, threshData);
+    if (thresholdValue < 0) {
+        thresholdValue = thresholdFor(region);
+    }
+    cv::threshold(region, thresh, thresholdValue, 255, cv::THRESH_BINARY_INV);
+    if (level < DegradationLevel::NoMorphology) {
+        cv::morphologyEx(thresh, thresh, cv::MORPH_CLOSE, cv::Mat(), cv::Point(-1, -1), 2);
+    }
+
+    // Find contours (outer only; holes can never outrank the blob around them)
+    cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    if (contours.empty()) {
+        return;
+    }
+
+    // Rank the largest contours in one pass, computing each area only once
+    size_t ranked[LINE_MAX_CANDIDATES];
+    double rankedAreas[LINE_MAX_CANDIDATES];
+    int rankedCount = 0;
+    for (size_t i = 0; i < contours.size(); i++) {
+        double area = cv::contourArea(contours[i]);
+        int position = rankedCount;
+        while (position > 0 && rankedAreas[position - 1] < area) {
+            position--;
+        }
+        if (position >= LINE_MAX_CANDIDATES) {
+            continue;
+        }
+
+        rankedCount = std::min(rankedCount + 1, LINE_MAX_CANDIDATES);
+        for (int j = rankedCount - 1; j > position; j--) {
+            ranked[j] = ranked[j - 1];
+            rankedAreas[j] = rankedAreas[j - 1];
+        }
+        ranked[position] = i;
+        rankedAreas[position] = area;
+    }
+
+    // Describe every ranked blob; the largest one becomes the main hit
+    for (int i = 0; i < rankedCount; i++) {
+        const std::vector<cv::Point> &contour = contours[ranked[i]];
+        cv::Moments M = cv::moments(contour);
+        cv::Rect bounds = cv::boundingRect(contour);
+
+        Blob &blob = hit.blobs[i];
+        blob.centerX = window.start + ((M.m00 != 0) ? M.m10 / M.m00 : region.cols / 2);
+        blob.width = bounds.width;
+        blob.area = rankedAreas[i];
+        blob.extent = rankedAreas[i] / static_cast<double>(bounds.area());
+
+        if (i == 0) {
+            hit.bounds = bounds;
+        }
+    }
+    hit.blobCount = rankedCount;
+
+    // Calculate the center of the largest contour
+    hit.found = true;
+    if (centroidMode == CentroidMode::IntensityWeighted) {
+        hit.centerX = window.start + weightedCentroid(region, thresh, hit.bounds,
+                                                      hit.blobs[0].centerX - window.start);
+        hit.blobs[0].centerX = hit.centerX;
+    } else {
+        hit.centerX = hit.blobs[0].centerX;
+    }
+    hit.clipped = (hit.bounds.x == 0 && window.start > 0) ||
+                    (hit.bounds.x + hit.bounds.width >= region.cols && window.end < slice.cols);
+
+    // Calculate extent of the contour & how much darker it is than its surroundings
+    hit.extent = hit.blobs[0].extent;
+    hit.contrast = blobContrast(region, thresh, hit.bounds);
+    if (drawOverlay) {
+        hit.contour = contours[ranked[0]];
+    }
+}
+
+double FrameProcessor::weightedCentroid(const cv::Mat &region, const cv::Mat &mask, const cv::Rect &bounds,
+                                        double contourX) const {
+    // Floor brightness from the unmasked pixels up to one blob width either side (as in
+    // blobContrast), so a blob touching the window edge isn't measured against itself
+    const int backgroundStart = std::max(0, bounds.x - bounds.width);
+    const int backgroundEnd = std::min(region.cols, bounds.x + 2 * bounds.width);
+    uint64_t backgroundSum = 0, backgroundCount = 0;
+    for (int y = 0; y < region.rows; y++) {
+        const uint8_t* row = region.ptr<uint8_t>(y);
+        const uint8_t* maskRow = mask.ptr<uint8_t>(y);
+        for (int x = backgroundStart; x < backgroundEnd; x++) {
+            if (!maskRow[x]) {
+                backgroundSum += row[x];
+                backgroundCount++;
+            }
+        }
+    }
+
+    // No floor to weigh against: the contour is the better answer
+    if (backgroundCount == 0) {
+        return contourX;
+    }
+    const double reference = static_cast<double>(backgroundSum) / backgroundCount;
+
+    // Look a little past the blob so the blurred, partially covered edge pixels count;
+    // darker pixels weigh more
+    const int margin = 4;
+    const int startX = std::max(0, bounds.x - margin);
+    const int endX = std::min(region.cols, bounds.x + bounds.width + margin);
+
+    double weightSum = 0;
+    double weightedX = 0;
+    for (int y = 0; y < region.rows; y++) {
+        const uint8_t* row = region.ptr<uint8_t>(y);
+        for (int x = startX; x < endX; x++) {
+            double weight = reference - row[x];
+            if (weight > 0) {
+                weightSum += weight;
+                weightedX += weight * x;
+            }
+        }
+    }
+
+    return (weightSum > 0) ? weightedX / weightSum : contourX;
+}
+
+double FrameProcessor::blobContrast(const cv::Mat &region, const cv::Mat &mask,
+                                    const cv::Rect &bounds) const {
+    // Compare the blob with the unmasked pixels up to one blob width either side of it
+    const int startX = std::max(0, bounds.x - bounds.width);
+    const int endX = std::min(region.cols, bounds.x + 2 * bounds.width);
+
+    uint64_t lineSum = 0, lineCount = 0;
+    uint64_t backgroundSum = 0, backgroundCount = 0;
+    for (int y = bounds.y; y < bounds.y + bounds.height; y++) {
+        const uint8_t* row = region.ptr<uint8_t>(y);
+        const uint8_t* maskRow = mask.ptr<uint8_t>(y);
+        for (int x = startX; x < endX; x++) {
+            if (maskRow[x]) {
+                lineSum += row[x];
+                lineCount++;
+            } else {
+                backgroundSum += row[x];
+                backgroundCount++;
+            }
+        }
+    }
+
+    // A blob spanning the whole window has nothing to compare against
+    if (lineCount == 0 || backgroundCount == 0) {
+        return 0;
+    }
+    double difference = static_cast<double>(backgroundSum) / backgroundCount -
+                        static_cast<double>(lineSum) / lineCount;
+    return std::max(0.0, difference / 255.0);
 }
 
 int* FrameProcessor::getDistances() const {
@@ -137,4 +766,166 @@ int* FrameProcessor::getDistances() const {
 
 int FrameProcessor::getSlices() {
     return this->slices;
+}
+
+void FrameProcessor::enableTracking(const SliceTracker::Options &options) {
+    trackingEnabled = true;
+    trackerOptions = options;
+    tracker.reset();
+}
+
+int FrameProcessor::getDistancesF(float* pixels, float* normalized, int maxSlices) const {
+    std::lock_guard<std::mutex> lock(distancesMutex);
+
+    int count = std::min(slices, maxSlices);
+    if (pixels) {
+        std::copy(distancesPx, distancesPx + count, pixels);
+    }
+    if (normalized) {
+        std::copy(distancesNorm, distancesNorm + count, normalized);
+    }
+    return count;
+}
+
+int FrameProcessor::getCandidates(SliceCandidates* out, int maxSlices) const {
+    std::lock_guard<std::mutex> lock(distancesMutex);
+
+    int count = std::min(slices, maxSlices);
+    std::copy(candidates.begin(), candidates.begin() + count, out);
+    return count;
+}
+
+int FrameProcessor::getStatus(SliceStatus* out, int maxSlices) const {
+    std::lock_guard<std::mutex> lock(distancesMutex);
+
+    int count = std::min(slices, maxSlices);
+    std::copy(statuses.begin(), statuses.begin() + count, out);
+    return count;
+}
+
+int FrameProcessor::getSnapshot(SliceResult* out, int maxSlices) const {
+    std::lock_guard<std::mutex> lock(distancesMutex);
+
+    int count = std::min(slices, maxSlices);
+    for (int i = 0; i < count; i++) {
+        out[i] = SliceResult{ distancesPx[i], distancesNorm[i], statuses[i] };
+    }
+    return count;
+}
+
+void FrameProcessor::setLensModel(std::unique_ptr<LensModel> model) {
+    lensModel = std::move(model);
+    geometrySize = cv::Size();
+}
+
+void FrameProcessor::setGroundMapper(std::unique_ptr<GroundMapper> mapper) {
+    groundMapper = std::move(mapper);
+    geometrySize = cv::Size();
+}
+
+int FrameProcessor::getGroundPoints(GroundPoint* out, int maxSlices) const {
+    std::lock_guard<std::mutex> lock(distancesMutex);
+
+    int count = std::min(slices, maxSlices);
+    std::copy(groundPoints.begin(), groundPoints.begin() + count, out);
+    return count;
+}
+
+int FrameProcessor::getHistory(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) const {
+    return history->read(sinceTimestampNs, out, maxCount);
+}
+
+void FrameProcessor::setHistoryLength(size_t records) {
+    history = std::make_unique<ResultHistory>(records);
+}
+
+void FrameProcessor::setCentroidMode(CentroidMode mode) {
+    centroidMode = mode;
+}
+
+void FrameProcessor::setInputFormat(uint32_t fourcc, size_t stride) {
+    const GrayFormat* format = findGrayFormat(fourcc);
+    if (!format) {
+        throw std::runtime_error("Unsupported input pixel format");
+    }
+    inputFormat = format;
+    inputStride = stride;
+    geometrySize = cv::Size(); // Specialized kernels are per format
+}
+
+void FrameProcessor::enablePyramid(int factor, int refineHalfWidth) {
+    requestedPyramidFactor = (factor == 2 || factor == 4) ? factor : 1;
+    this->refineHalfWidth = refineHalfWidth;
+    geometrySize = cv::Size(); // The strip buffer depends on the refine width
+    applyLevel(level);
+}
+
+void FrameProcessor::enableDeadlines(double fps, const DeadlineGovernor::Options &options) {
+    {
+        std::lock_guard<std::mutex> lock(deadlinesMutex);
+        deadlines = std::make_unique<DeadlineGovernor>(static_cast<uint64_t>(1e9 / fps), options);
+    }
+    // The level, pyramid factor & tracker belong to the processing thread
+    pendingLevel.store(static_cast<int>(DegradationLevel::Full), std::memory_order_release);
+}
+
+DeadlineGovernor::Stats FrameProcessor::getDeadlineStats() const {
+    std::lock_guard<std::mutex> lock(deadlinesMutex);
+    return deadlines ? deadlines->getStats() : DeadlineGovernor::Stats{};
+}
+
+void FrameProcessor::applyLevel(DegradationLevel newLevel) {
+    level = newLevel;
+
+    const int factor = (level >= DegradationLevel::Decimated) ? std::max(requestedPyramidFactor, 2)
+                                                             : requestedPyramidFactor;
+    if (factor != pyramidFactor) {
+        pyramidFactor = factor;
+        tracker.reset(); // Track positions are in the searched level's pixels
+        geometrySize = cv::Size();
+    }
+}
+
+void FrameProcessor::setThresholdMode(ThresholdMode mode) {
+    thresholdMode = mode;
+    sliceHistograms.assign(mode == ThresholdMode::Otsu ? slices * 256 : 0, 0);
+    previousSliceMeans.clear();
+}
+
+void FrameProcessor::setSliceSchedule(const SliceSchedule &schedule) {
+    if (!schedule.empty() && schedule.size() != slices) {
+        throw std::runtime_error("Slice schedule has " + std::to_string(schedule.size()) +
+                                 " slices, expected " + std::to_string(slices));
+    }
+
+    std::lock_guard<std::mutex> lock(scheduleMutex);
+    this->schedule = schedule;
+}
+
+void FrameProcessor::setSpeed(double speed) {
+    setSliceSchedule(SliceSchedule::forSpeed(slices, speed));
+}
+
+void FrameProcessor::setFrameWindow(int fullHeight, int rowOffset) {
+    windowFullHeight = fullHeight;
+    windowOffset = (fullHeight > 0) ? rowOffset : 0;
+    geometrySize = cv::Size();
+    previousSliceMeans.clear();
+    if (tracker) {
+        tracker->reset();
+    }
+}
+
+void FrameProcessor::setSliceLayout(const SliceLayout &layout) {
+    if (layout.size() != slices) {
+        throw std::runtime_error("Slice layout has " + std::to_string(layout.size()) +
+                                 " slices, expected " + std::to_string(slices));
+    }
+
+    sliceLayout = layout;
+    geometrySize = cv::Size();
+    previousSliceMeans.clear();
+    if (tracker) {
+        tracker->reset();
+    }
 }
\ No newline at end of file
@@ -1,22 +1,145 @@
 #ifndef _FRAME_PROCESSOR_HPP_
 #define _FRAME_PROCESSOR_HPP_
 
+#include <atomic>
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <mutex>
+#include <memory>
+
+#include "DeadlineGovernor.hpp"
+#include "FrameProcessorT.hpp"
+#include "GroundMapper.hpp"
+#include "LensModel.hpp"
+#include "ResultHistory.hpp"
+#include "ScratchArena.hpp"
+#include "SliceLayout.hpp"
+#include "SliceSchedule.hpp"
+#include "LineResult.h"
+#include "SliceTracker.hpp"
 
 class FrameProcessor {
 public:
+    enum class CentroidMode {
+        Contour,          // Centroid of the largest contour's polygon
+        IntensityWeighted // Darkness-weighted centroid of the gray pixels around the blob
+    };
+
+    enum class ThresholdMode {
+        RegionMean,        // cv::mean over the searched region (extra pass per slice)
+        SliceMean,         // Slice means summed during the gray conversion pass
+        PreviousSliceMean, // Last frame's slice means; known before the frame is touched
+        Otsu               // Otsu over per-slice histograms built in the conversion pass
+    };
+
+    // Cumulative: each level also keeps every saving of the levels before it
+    enum class DegradationLevel {
+        Full,
+        NoMorphology,  // Threshold without the closing pass
+        Decimated,     // Search a half resolution copy (pyramid 2) if not already coarser
+        ReducedSlices, // Each slice only every other frame
+        NoOverlay      // No debug drawing or preview window
+    };
+
+    // Scratch arena size & the page faults the processing thread took inside processFrame
+    struct MemoryStats {
+        uint64_t arenaBytes;
+        bool hugePages;           // THP advised for the arena
+        uint64_t frames;
+        uint64_t minorFaults;
+        uint64_t majorFaults;
+        uint64_t lastMinorFaults; // Latest frame only
+        uint64_t lastMajorFaults;
+    };
+
     FrameProcessor(int numOfSlices, double meanIntensityMult,
                     int minThreshold, int maxThreshold, bool debug);
     ~FrameProcessor();
 
+    // timestampNs is the capture time kept in the history; 0 = stamp it with the
+    // monotonic clock on arrival
     void processFrame(cv::Mat &frame, unsigned int height, unsigned int width,
-                        const uint8_t* buffer);
+                        const uint8_t* buffer, uint64_t sequence = 0, uint64_t timestampNs = 0);
     int* getDistances() const;
     int getSlices();
 
+    // Sub-pixel distances: pixels from the slice middle and normalized to [-1, 1].
+    // Either output may be null. Returns the number of slices copied.
+    int getDistancesF(float* pixels, float* normalized, int maxSlices) const;
+
+    // Up to LINE_MAX_CANDIDATES blobs per slice, ranked by area, for forks & crossings.
+    // With tracking only blobs inside the search window are seen. Returns slices copied.
+    int getCandidates(SliceCandidates* out, int maxSlices) const;
+
+    // Line-present flag & confidence of every slice, rewritten each frame (found or not)
+    // so stale distances can be told apart. Returns the number of slices copied.
+    int getStatus(SliceStatus* out, int maxSlices) const;
+
+    // Distances & status of every slice in one locked copy, unlike separate getDistancesF
+    // and getStatus calls which a frame can land between. Returns the number of slices copied.
+    int getSnapshot(SliceResult* out, int maxSlices) const;
+
+    // Every frame's results also go to a ring of the latest records; see ResultHistory::read.
+    // Lock & allocation free, callable from any thread.
+    int getHistory(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) const;
+
+    // Ring size in frames (default 128). Not safe once frames or readers are running.
+    void setHistoryLength(size_t records);
+
+    void setCentroidMode(CentroidMode mode);
+
+    // Layout of the buffers handed to processFrame as a libcamera fourcc (one of
+    // GrayKernels'; planar YUV is processed on its Y plane in place) & bytes per row
+    // (0 = packed). Defaults to XRGB8888; throws std::runtime_error if unsupported.
+    void setInputFormat(uint32_t fourcc, size_t stride);
+
+    // Correct float distances, candidates & ground points for lens distortion. The
+    // integer distances & debug overlay stay in raw pixels.
+    void setLensModel(std::unique_ptr<LensModel> model);
+
+    // Also publish each slice's centroid on the ground plane
+    void setGroundMapper(std::unique_ptr<GroundMapper> mapper);
+    int getGroundPoints(GroundPoint* out, int maxSlices) const;
+
+    // Restrict each slice's search to a window around the tracked line position
+    void enableTracking(const SliceTracker::Options &options);
+
+    // Find the line on a 1/factor (2 or 4) gray copy, then refine it on a full
+    // resolution strip of +/- refineHalfWidth pixels around the coarse hit
+    void enablePyramid(int factor, int refineHalfWidth);
+
+    void setThresholdMode(ThresholdMode mode);
+
+    // Rows searched by each slice; the layout must have one range per slice or
+    // std::runtime_error is thrown. Without one the frame is split evenly.
+    void setSliceLayout(const SliceLayout &layout);
+
+    // Frames are rows [rowOffset, rowOffset + frame height) of a fullHeight frame (a
+    // sensor-side crop). Slice layouts and calibrations stay in uncropped rows; an even
+    // split covers just the delivered rows. fullHeight 0 = frames are uncropped.
+    void setFrameWindow(int fullHeight, int rowOffset);
+
+    // Resolves the geometry & maps and touches the scratch arena for frames of this
+    // size, so the first frames don't page fault (i.e. at configuration or before mlockall)
+    void prefault(const cv::Size &frameSize);
+
+    // Back the arena with transparent huge pages; it is rebuilt by the next prefault
+    // or frame. Not safe while frames are being processed.
+    void setHugePages(bool enabled);
+    MemoryStats getMemoryStats() const;
+
+    // Evaluate slices at different rates; skipped slices keep their last results and are
+    // marked as not refreshed. Safe to call while frames are being processed.
+    void setSliceSchedule(const SliceSchedule &schedule);
+    void setSpeed(double speed); // Schedule from SliceSchedule::forSpeed
+
+    // Step down through DegradationLevel when processing repeatedly overruns the frame
+    // interval at fps, and back up once there is headroom again. Safe to call while frames
+    // are being processed: the reset to full quality waits for the next frame to start.
+    void enableDeadlines(double fps, const DeadlineGovernor::Options &options);
+    DeadlineGovernor::Stats getDeadlineStats() const;
+
 private:
     int slices;
     double meanIntensityMult;
@@ -25,9 +148,127 @@ private:
     bool debugMode = false;
 
     int* distances; 
+    float* distancesPx;
+    float* distancesNorm;
+    std::vector<SliceCandidates> candidates; // Preallocated, one record per slice
+    std::vector<SliceStatus> statuses;
+    std::vector<GroundPoint> groundPoints;
+    uint64_t frameSequence = 0;
     mutable std::mutex distancesMutex;
+    std::unique_ptr<ResultHistory> history;
+
+    CentroidMode centroidMode = CentroidMode::Contour;
+
+    bool trackingEnabled = false;
+    SliceTracker::Options trackerOptions;
+    std::unique_ptr<SliceTracker> tracker; // Sized lazily from the first frame's width
+
+    // Slice geometry, statistics bands & the lens/ground tables are resolved once per
+    // frame size so no geometry is computed per frame
+    struct SliceGeometry {
+        cv::Range rows;    // Frame rows
+        cv::Rect grayROI;  // Slice in the searched gray image (decimated with the pyramid)
+        double centerRow;  // Frame row the centroid is reported on
+        int bandPixels;    // Gray pixels summed into the slice's statistics
+        bool visible;      // False when the slice lies outside the delivered window
+    };
+    SliceLayout sliceLayout; // Requested layout; empty = uniform
+    int windowFullHeight = 0;
+    int windowOffset = 0;
+    std::vector<SliceGeometry> geometry;
+    int visibleSlices = 0;
+    std::vector<int> rowBands; // Gray row -> slice, -1 between slices
+    cv::Size geometrySize;
+    std::vector<int> loneBandRows; // All zeros: a single slice's rows as band 0
+
+    SliceSchedule schedule;
+    mutable std::mutex scheduleMutex;
+    uint64_t processedFrames = 0;
+    std::vector<char> dueSlices;
+
+    std::unique_ptr<LensModel> lensModel;
+    std::unique_ptr<GroundMapper> groundMapper;
+
+    // Intermediate images are headers over one prefaulted arena, laid out at fixed
+    // offsets whenever the geometry is resolved, so steady state processing neither
+    // allocates nor faults
+    bool hugePages = false;
+    std::unique_ptr<ScratchArena> arena;
+    cv::Mat gray;
+    cv::Mat unblurred; // Per-slice conversion source for the blur when slices are skipped
+    cv::Mat strip;
+    uint8_t* stripData = nullptr;  // Backs `strip`, sized for the tallest slice
+    uint8_t* threshData = nullptr; // Mask of the searched region (a slice or a strip)
+    std::vector<std::vector<cv::Point>> contours; // Keeps its capacity between slices
+    std::vector<cv::Point> contourCenters;
+
+    MemoryStats memoryStats{};
+    mutable std::mutex memoryMutex;
+
+    int pyramidFactor = 1;          // In effect, after degradation
+    int requestedPyramidFactor = 1; // From enablePyramid
+    int refineHalfWidth = 24;
+
+    std::unique_ptr<DeadlineGovernor> deadlines;
+    mutable std::mutex deadlinesMutex;
+    DegradationLevel level = DegradationLevel::Full;
+    std::atomic<int> pendingLevel{-1}; // From enableDeadlines, applied as a frame starts
+    bool drawOverlay = false;
+
+    const GrayFormat* inputFormat = findGrayFormat(FOURCC_XRGB8888); // Picked once, never per frame
+    size_t inputStride = 0;
+
+    // Per-slice statistics gathered while converting to gray
+    ThresholdMode thresholdMode = ThresholdMode::RegionMean;
+    std::vector<uint64_t> sliceSums;
+    std::vector<uint32_t> sliceHistograms; // 256 bins per slice, Otsu only
+    std::vector<double> previousSliceMeans; // Empty until the first frame, -1 = slice skipped
+    std::vector<int> sliceThresholds;       // -1 = compute from the searched region
+
+    // Fixed-geometry conversion kernel for the current frame size & an even layout,
+    // if one was prebuilt
+    GrayStatsKernel specializedKernel = nullptr;
+
+    // Blob in the coordinates of the searched level
+    struct Blob {
+        double centerX;
+        double width;
+        double area;
+        double extent;
+    };
+
+    // Largest blob found in (a window of) a slice, in slice coordinates
+    struct SliceHit {
+        bool found = false;
+        bool clipped = false; // Blob touches a window edge that isn't the slice edge
+        double centerX = 0;
+        int offsetX = 0;
+        int width = 0;
+        double extent = 0;
+        double contrast = 0;
+        cv::Rect bounds;
+        std::vector<cv::Point> contour;
+        Blob blobs[LINE_MAX_CANDIDATES]; // blobs[0] is the main blob
+        int blobCount = 0;
+    };
 
-    cv::Point processSlice(cv::Mat &slice, int sliceIndex, cv::Mat &frame, int sliceHeight);
+    void prepareGeometry(const cv::Size &frameSize);
+    void layoutArena(const cv::Size &frameSize, int tallestFrameSlice);
+    void applyLevel(DegradationLevel newLevel);
+    int updateDueSlices();
+    void convertSlice(const cv::Mat &frame, int sliceIndex, bool gatherStats, uint32_t* histograms);
+    cv::Point processSlice(cv::Mat &slice, int sliceIndex, cv::Mat &frame);
+    cv::Point processSlicePyramid(cv::Mat &coarseSlice, int sliceIndex, cv::Mat &frame);
+    SliceHit searchSlice(const cv::Mat &slice, int sliceIndex);
+    void updateSliceThresholds();
+    cv::Point publishSlice(const SliceHit &hit, int sliceIndex, cv::Mat &frame);
+    void publishHistory(uint64_t timestampNs);
+    int thresholdFor(const cv::Mat &region) const;
+    void findLine(const cv::Mat &slice, const cv::Range &window, SliceHit &hit,
+                    int thresholdValue = -1);
+    double weightedCentroid(const cv::Mat &region, const cv::Mat &mask, const cv::Rect &bounds,
+                            double contourX) const;
+    double blobContrast(const cv::Mat &region, const cv::Mat &mask, const cv::Rect &bounds) const;
 };
 
 #endif
\ No newline at end of file
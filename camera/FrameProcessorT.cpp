@@ -0,0 +1,73 @@
+#include "FrameProcessorT.hpp"
+#include "GrayKernelsImpl.hpp"
+
+// Converts one row of exactly Width pixels & returns the sum of its gray values
+template <int Width>
+static inline uint32_t convertRowFixed(const uint8_t* src, uint8_t* dst) {
+#if defined(__ARM_NEON)
+    uint32x4_t accumulated = vdupq_n_u32(0);
+#pragma GCC unroll 8
+    for (int x = 0; x < Width; x += 16) {
+        convert16Neon(src + x * 4, dst + x, accumulated);
+    }
+    return horizontalSum(accumulated);
+#else
+    uint32_t sum = 0;
+#pragma GCC unroll 16
+    for (int x = 0; x < Width; x++) {
+        const uint8_t* pixel = src + x * 4;
+        dst[x] = blockToGray(pixel[0], pixel[1], pixel[2], 0);
+        sum += dst[x];
+    }
+    return sum;
+#endif
+}
+
+template <int Width, int Height, int Slices, uint32_t Fourcc>
+void FrameProcessorT<Width, Height, Slices, Fourcc>::convertWithStats(
+        const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+        uint64_t* sliceSums, uint32_t* sliceHistograms) {
+    for (int slice = 0; slice < Slices; slice++) {
+        uint64_t sum = 0;
+        for (int y = slice * sliceHeight; y < (slice + 1) * sliceHeight; y++) {
+            uint8_t* dstRow = dst + y * dstStride;
+            sum += convertRowFixed<Width>(src + y * srcStride, dstRow);
+            if (sliceHistograms) {
+                accumulateHistogram(dstRow, Width, sliceHistograms + slice * 256);
+            }
+        }
+        sliceSums[slice] = sum;
+    }
+
+    // Rows below the last slice are converted for the preview but never counted
+    for (int y = Slices * sliceHeight; y < Height; y++) {
+        convertRowFixed<Width>(src + y * srcStride, dst + y * dstStride);
+    }
+}
+
+struct Specialization {
+    int width;
+    int height;
+    int slices;
+    uint32_t fourcc;
+    GrayStatsKernel kernel;
+};
+
+static const Specialization SPECIALIZATIONS[] = {
+    // Production configuration
+    { 640, 480, 5, FOURCC_XRGB8888, &FrameProcessorT<640, 480, 5, FOURCC_XRGB8888>::convertWithStats },
+    // Half resolution for the sub-pixel path
+    { 320, 240, 5, FOURCC_XRGB8888, &FrameProcessorT<320, 240, 5, FOURCC_XRGB8888>::convertWithStats },
+    // Golden frames, so the gate exercises the specialized path
+    { 160, 120, 5, FOURCC_XRGB8888, &FrameProcessorT<160, 120, 5, FOURCC_XRGB8888>::convertWithStats },
+};
+
+GrayStatsKernel findSpecializedKernel(int width, int height, int slices, uint32_t fourcc) {
+    for (const Specialization &specialization : SPECIALIZATIONS) {
+        if (specialization.width == width && specialization.height == height &&
+            specialization.slices == slices && specialization.fourcc == fourcc) {
+            return specialization.kernel;
+        }
+    }
+    return nullptr;
+}
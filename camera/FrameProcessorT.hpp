@@ -0,0 +1,33 @@
+#ifndef _FRAME_PROCESSOR_T_HPP_
+#define _FRAME_PROCESSOR_T_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GrayKernels.hpp"
+
+// Hot path for one fixed configuration. Geometry is constexpr so the gray conversion
+// & per-slice statistics loops have known trip counts, whole 16 pixel vectors and no
+// remainder handling; FrameProcessor dispatches here when its configuration matches
+// a prebuilt specialization.
+template <int Width, int Height, int Slices, uint32_t Fourcc>
+struct FrameProcessorT {
+    static_assert(Fourcc == FOURCC_XRGB8888, "Only XRGB8888 has a specialized kernel");
+    static_assert(Width % 16 == 0, "Rows must be whole 16 pixel vectors");
+    static_assert(Slices > 0 && Height >= Slices, "Every slice needs at least one row");
+
+    static constexpr int sliceHeight = Height / Slices;
+    static constexpr int slicePixels = Width * sliceHeight;
+
+    // Same contract as XRGB8888's toGrayWithStats with the geometry baked in
+    static void convertWithStats(const uint8_t* src, size_t srcStride, uint8_t* dst,
+                                    size_t dstStride, uint64_t* sliceSums, uint32_t* sliceHistograms);
+};
+
+using GrayStatsKernel = void (*)(const uint8_t* src, size_t srcStride, uint8_t* dst,
+                                    size_t dstStride, uint64_t* sliceSums, uint32_t* sliceHistograms);
+
+// Prebuilt specialization for this configuration, or nullptr for the generic path
+GrayStatsKernel findSpecializedKernel(int width, int height, int slices, uint32_t fourcc);
+
+#endif
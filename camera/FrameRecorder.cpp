@@ -0,0 +1,148 @@
+#include "FrameRecorder.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>    // open & posix_fallocate
+#include <unistd.h>   // close & sysconf
+#include <sys/mman.h> // mmap, msync & munmap
+
+static size_t alignToPage(size_t bytes) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) / page * page;
+}
+
+FrameRecorder::FrameRecorder(const std::string &path, uint32_t width, uint32_t height,
+                                uint32_t stride, uint32_t pixelFormat, uint32_t slotCount,
+                                uint32_t everyNth) {
+    if (slotCount == 0) {
+        throw std::invalid_argument("Recorder needs at least one slot");
+    }
+
+    const uint32_t frameBytes = stride * height;
+    const size_t slotBytes = alignToPage(frameBytes);
+    const size_t dataOffset = alignToPage(sizeof(RecordingHeader) + slotCount * sizeof(RecordingSlot));
+    mappedSize = dataOffset + slotBytes * slotCount;
+
+    // Reserve the whole ring up front so the hot path never extends the file
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open recording file " + path);
+    }
+    if (posix_fallocate(fd, 0, static_cast<off_t>(mappedSize)) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to preallocate recording file " + path);
+    }
+
+    // Populate the mapping now so the first recorded frames don't page fault
+    void* data_ = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (data_ == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map recording file " + path);
+    }
+    mapped = static_cast<uint8_t*>(data_);
+
+    header = reinterpret_cast<RecordingHeader*>(mapped);
+    slots = reinterpret_cast<RecordingSlot*>(mapped + sizeof(RecordingHeader));
+
+    std::memset(mapped, 0, dataOffset);
+    std::memcpy(header->magic, RECORDING_MAGIC, sizeof(header->magic));
+    header->version = RECORDING_VERSION;
+    header->slotCount = slotCount;
+    header->width = width;
+    header->height = height;
+    header->stride = stride;
+    header->pixelFormat = pixelFormat;
+    header->frameBytes = frameBytes;
+    header->everyNth = everyNth == 0 ? 1 : everyNth;
+    header->slotBytes = slotBytes;
+    header->dataOffset = dataOffset;
+
+    writer = std::thread(&FrameRecorder::writerLoop, this);
+    std::cout << "Recording every " << header->everyNth << " frame(s) into " << slotCount
+                << " slots at " << path << std::endl;
+}
+
+FrameRecorder::~FrameRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    // Flush whatever the kernel hasn't written back yet before closing the session
+    msync(mapped, mappedSize, MS_SYNC);
+    munmap(mapped, mappedSize);
+    close(fd);
+}
+
+bool FrameRecorder::shouldRecord() {
+    return (completedFrames++ % header->everyNth) == 0;
+}
+
+bool FrameRecorder::submit(const uint8_t* data, const FrameInfo &info, std::function<void()> done) {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (busy || stopping) {
+            header->framesSkipped++;
+            return false;
+        }
+        busy = true;
+        jobData = data;
+        jobInfo = info;
+        jobDone = std::move(done);
+    }
+    jobReady.notify_one();
+    return true;
+}
+
+int FrameRecorder::applyThreadPolicy(const ThreadPolicy &policy) {
+    return ::applyThreadPolicy(writer.native_handle(), policy);
+}
+
+void FrameRecorder::writerLoop() {
+    std::unique_lock<std::mutex> lock(jobMutex);
+    while (true) {
+        jobReady.wait(lock, [this] { return busy || stopping; });
+        if (!busy) {
+            return;
+        }
+
+        const uint8_t* data = jobData;
+        FrameInfo info = jobInfo;
+        std::function<void()> done = std::move(jobDone);
+        lock.unlock();
+
+        writeFrame(data, info);
+        done(); // Source buffer is no longer needed
+
+        lock.lock();
+        busy = false;
+    }
+}
+
+void FrameRecorder::writeFrame(const uint8_t* data, const FrameInfo &info) {
+    const uint64_t index = header->framesWritten % header->slotCount;
+    RecordingSlot &slot = slots[index];
+    uint8_t* target = mapped + header->dataOffset + index * header->slotBytes;
+
+    // Invalidate the slot before overwriting it so a torn frame is never trusted
+    slot.valid = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(target, data, header->frameBytes);
+
+    slot.sequence = info.sequence;
+    slot.timestampNs = info.timestampNs;
+    slot.exposureUs = info.exposureUs;
+    slot.bytes = header->frameBytes;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.valid = 1;
+    header->framesWritten++;
+
+    // Start writeback now so a crash or power cut loses as little as possible
+    msync(target, header->slotBytes, MS_ASYNC);
+}
@@ -0,0 +1,59 @@
+#ifndef _FRAME_RECORDER_HPP_
+#define _FRAME_RECORDER_HPP_
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "Realtime.hpp"
+#include "RecordingFormat.hpp"
+
+class FrameRecorder {
+public:
+    struct FrameInfo {
+        uint64_t sequence;
+        uint64_t timestampNs;
+        int64_t exposureUs;
+    };
+
+    FrameRecorder(const std::string &path, uint32_t width, uint32_t height, uint32_t stride,
+                    uint32_t pixelFormat, uint32_t slotCount, uint32_t everyNth);
+    ~FrameRecorder();
+
+    // Counts a completed frame & tells whether it is one we want to keep
+    bool shouldRecord();
+
+    // Hands a frame to the writer thread. `done` is invoked from the writer thread
+    // once the pixels are copied so the caller can recycle the buffer. Returns false
+    // (and never calls `done`) if the writer is still busy with the previous frame.
+    bool submit(const uint8_t* data, const FrameInfo &info, std::function<void()> done);
+
+    // Scheduling & CPU placement of the writer thread
+    int applyThreadPolicy(const ThreadPolicy &policy);
+
+private:
+    int fd = -1;
+    uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    RecordingHeader* header = nullptr;
+    RecordingSlot* slots = nullptr;
+    uint64_t completedFrames = 0;
+
+    // Single pending job; the camera thread never waits on the writer
+    std::thread writer;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    bool busy = false;
+    bool stopping = false;
+    const uint8_t* jobData = nullptr;
+    FrameInfo jobInfo{};
+    std::function<void()> jobDone;
+
+    void writerLoop();
+    void writeFrame(const uint8_t* data, const FrameInfo &info);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "FrameReplayer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+FrameReplayer::FrameReplayer(FrameProcessor &processor, Pacing pacing)
+    : processor(processor), pacing(pacing) {}
+
+FrameReplayer::Stats FrameReplayer::run(const RecordingReader &reader,
+                                        const std::function<void(const FrameResult&)> &onFrame) {
+    using Clock = std::chrono::steady_clock;
+
+    const RecordingHeader &header = reader.getHeader();
+    const std::vector<RecordingReader::Frame> &frames = reader.getFrames();
+    const int slices = processor.getSlices();
+
+    Stats stats;
+    stats.frames = frames.size();
+    std::vector<uint64_t> timings;
+    timings.reserve(frames.size());
+
+    cv::Mat frame;
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < frames.size(); i++) {
+        const RecordingReader::Frame &recorded = frames[i];
+        FrameResult result{ recorded.sequence, recorded.timestampNs, 0, false, {} };
+
+        // Anything beyond the recording stride never made it into the file
+        if (i > 0) {
+            const uint64_t step = recorded.sequence - frames[i - 1].sequence;
+            if (step > header.everyNth) {
+                stats.captureDrops += step / header.everyNth - 1;
+            }
+        }
+
+        if (pacing == Pacing::Realtime) {
+            auto dueAt = [&](size_t index) {
+                return start + std::chrono::nanoseconds(frames[index].timestampNs - frames[0].timestampNs);
+            };
+
+            // The sensor would already have overwritten this frame; skip it like the camera would
+            if (i + 1 < frames.size() && Clock::now() >= dueAt(i + 1)) {
+                stats.pacingDrops++;
+                result.dropped = true;
+                onFrame(result);
+                continue;
+            }
+            std::this_thread::sleep_until(dueAt(i));
+        }
+
+        const Clock::time_point before = Clock::now();
+        processor.processFrame(frame, header.height, header.width, recorded.data, recorded.sequence,
+                                recorded.timestampNs);
+        result.processNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count());
+
+        int* distances = processor.getDistances();
+        result.distances.assign(distances, distances + slices);
+        delete[] distances;
+
+        timings.push_back(result.processNs);
+        stats.processed++;
+        onFrame(result);
+    }
+    stats.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!timings.empty()) {
+        double total = 0;
+        for (uint64_t t : timings) {
+            total += static_cast<double>(t);
+        }
+        stats.meanNs = total / timings.size();
+
+        std::sort(timings.begin(), timings.end());
+        stats.p50Ns = timings[timings.size() / 2];
+        stats.p99Ns = timings[std::min(timings.size() - 1, timings.size() * 99 / 100)];
+        stats.maxNs = timings.back();
+    }
+
+    return stats;
+}
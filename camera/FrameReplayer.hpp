@@ -0,0 +1,47 @@
+#ifndef _FRAME_REPLAYER_HPP_
+#define _FRAME_REPLAYER_HPP_
+
+#include <functional>
+#include <vector>
+
+#include "FrameProcessor.hpp"
+#include "RecordingReader.hpp"
+
+// Feeds recorded frames through a FrameProcessor without a camera attached
+class FrameReplayer {
+public:
+    enum class Pacing {
+        AsFastAsPossible, // Back to back; measures raw throughput
+        Realtime          // Released at the recorded timestamps; late frames are dropped
+    };
+
+    struct FrameResult {
+        uint64_t sequence;
+        uint64_t timestampNs;
+        uint64_t processNs;
+        bool dropped;
+        std::vector<int> distances;
+    };
+
+    struct Stats {
+        size_t frames = 0;
+        size_t processed = 0;
+        size_t captureDrops = 0; // Gaps in the recorded sequence numbers
+        size_t pacingDrops = 0;  // Frames skipped because processing fell behind
+        double meanNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t maxNs = 0;
+        double wallSeconds = 0;
+    };
+
+    FrameReplayer(FrameProcessor &processor, Pacing pacing);
+
+    Stats run(const RecordingReader &reader, const std::function<void(const FrameResult&)> &onFrame);
+
+private:
+    FrameProcessor &processor;
+    Pacing pacing;
+};
+
+#endif
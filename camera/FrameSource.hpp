@@ -0,0 +1,73 @@
+#ifndef _FRAME_SOURCE_HPP_
+#define _FRAME_SOURCE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <libcamera/libcamera.h>
+
+#include "ExposurePlan.hpp"
+
+// Where frames come from. CameraSensor only talks to this interface so the
+// request queue, recording & processing flow run the same on & off the car.
+class FrameSource {
+public:
+    using PixelFormat = libcamera::PixelFormat;
+    using StreamRole = libcamera::StreamRole;
+
+    struct Format {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+        uint32_t fourcc = 0;
+
+        // With a sensor-side crop the frames are rows [rowOffset, rowOffset + height) of
+        // an uncropped frame fullHeight rows tall; fullHeight is 0 without one
+        uint32_t fullHeight = 0;
+        uint32_t rowOffset = 0;
+    };
+
+    // A completed frame; stays valid until handed back through release()
+    struct Frame {
+        const uint8_t* data;
+        size_t bytes;
+        uint64_t sequence;
+        uint64_t timestampNs;
+        int64_t exposureUs; // -1 if the source doesn't report it
+        uint64_t cookie;    // Source private; identifies the buffer to recycle
+        unsigned int stream;    // 0 = processing, 1 = recording
+        const Frame* recording; // Same exposure on the recording stream, if it got a buffer
+    };
+
+    using FrameCallback = std::function<void(const Frame&)>;
+
+    virtual ~FrameSource() = default;
+
+    virtual int configure(const uint_fast32_t width, const uint_fast32_t height,
+                            const PixelFormat pixelFormat, const StreamRole role) = 0;
+    virtual const Format& getFormat() const = 0;
+
+    // Second stream delivered with each frame for recording; width 0 = none, record
+    // the processing stream itself
+    virtual const Format& getRecordingFormat() const = 0;
+
+    // Buffer count is used by the next configure() (0 keeps the source's default), frame
+    // timing & exposure by the next start()
+    virtual void setBufferCount(unsigned int count) = 0;
+    virtual void setExposure(const ExposureSettings &settings) = 0;
+
+    // Only deliver rows [top, top + height) (shares of the frame) from the next
+    // configure(); height 0 = the whole frame
+    virtual void setBandOfInterest(double top, double height) = 0;
+
+    // Frames are delivered on the source's completion thread
+    virtual void start(FrameCallback onFrame) = 0;
+    virtual void stop() = 0;
+
+    // Returns the frame's buffer to the source; may be called from any thread. The
+    // recording frame is released separately from the frame that carried it.
+    virtual void release(const Frame &frame) = 0;
+};
+
+#endif
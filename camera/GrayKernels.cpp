@@ -0,0 +1,350 @@
+#include "GrayKernels.hpp"
+#include "GrayKernelsImpl.hpp"
+
+#include <algorithm>
+
+// Packed RGB, bytes per pixel & the byte offset of each channel within a pixel
+template <int Bpp, int BlueAt, int GreenAt, int RedAt>
+struct RgbLayout {
+    static constexpr int bytesPerPixel = Bpp;
+    static constexpr bool luma = false;
+    static constexpr int B = BlueAt;
+    static constexpr int G = GreenAt;
+    static constexpr int R = RedAt;
+};
+
+// Y samples every Bpp bytes from byte YAt: a Y plane (1) or packed 4:2:2 (2)
+template <int Bpp, int YAt>
+struct LumaLayout {
+    static constexpr int bytesPerPixel = Bpp;
+    static constexpr bool luma = true;
+    static constexpr int Y = YAt;
+};
+
+template <class Layout>
+static void decimateRow(const uint8_t* src, size_t srcStride, int factor, int shift,
+                        int fromX, int outWidth, uint8_t* dst) {
+    constexpr int bpp = Layout::bytesPerPixel;
+    for (int ox = fromX; ox < outWidth; ox++) {
+        uint32_t sumB = 0, sumG = 0, sumR = 0, sumY = 0;
+        for (int dy = 0; dy < factor; dy++) {
+            const uint8_t* pixel = src + dy * srcStride + static_cast<size_t>(ox) * factor * bpp;
+            for (int dx = 0; dx < factor; dx++, pixel += bpp) {
+                if constexpr (Layout::luma) {
+                    sumY += pixel[Layout::Y];
+                } else {
+                    sumB += pixel[Layout::B];
+                    sumG += pixel[Layout::G];
+                    sumR += pixel[Layout::R];
+                }
+            }
+        }
+        if constexpr (Layout::luma) {
+            dst[ox] = static_cast<uint8_t>((sumY + (1u << (shift - 1))) >> shift);
+        } else {
+            dst[ox] = blockToGray(sumB, sumG, sumR, shift);
+        }
+    }
+}
+
+template <class Layout>
+static uint32_t convertRow(const uint8_t* src, int fromX, int width, uint8_t* dst) {
+    uint32_t sum = 0;
+    for (int x = fromX; x < width; x++) {
+        const uint8_t* pixel = src + static_cast<size_t>(x) * Layout::bytesPerPixel;
+        if constexpr (Layout::luma) {
+            dst[x] = pixel[Layout::Y];
+        } else {
+            dst[x] = blockToGray(pixel[Layout::B], pixel[Layout::G], pixel[Layout::R], 0);
+        }
+        sum += dst[x];
+    }
+    return sum;
+}
+
+#if defined(__ARM_NEON)
+// Channels of 16 consecutive RGB pixels
+template <class Layout>
+static inline void load16(const uint8_t* src, uint8x16_t &b, uint8x16_t &g, uint8x16_t &r) {
+    if constexpr (Layout::bytesPerPixel == 4) {
+        uint8x16x4_t pixels = vld4q_u8(src);
+        b = pixels.val[Layout::B];
+        g = pixels.val[Layout::G];
+        r = pixels.val[Layout::R];
+    } else {
+        uint8x16x3_t pixels = vld3q_u8(src);
+        b = pixels.val[Layout::B];
+        g = pixels.val[Layout::G];
+        r = pixels.val[Layout::R];
+    }
+}
+
+// Y samples of 16 consecutive pixels
+template <class Layout>
+static inline uint8x16_t load16Luma(const uint8_t* src) {
+    if constexpr (Layout::bytesPerPixel == 1) {
+        return vld1q_u8(src);
+    } else {
+        return vld2q_u8(src).val[Layout::Y];
+    }
+}
+
+// 16 pixels at a time; returns how many were converted & adds their sum to `sum`
+template <class Layout>
+static int convertRowNeon(const uint8_t* src, int width, uint8_t* dst, uint64_t &sum) {
+    uint32x4_t accumulated = vdupq_n_u32(0);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* pixels = src + static_cast<size_t>(x) * Layout::bytesPerPixel;
+        if constexpr (Layout::luma) {
+            uint8x16_t y = load16Luma<Layout>(pixels);
+            vst1q_u8(dst + x, y);
+            accumulated = vpadalq_u16(accumulated, vpaddlq_u8(y));
+        } else {
+            uint8x16_t b, g, r;
+            load16<Layout>(pixels, b, g, r);
+            convert16Neon(b, g, r, dst + x, accumulated);
+        }
+    }
+    sum += horizontalSum(accumulated);
+    return x;
+}
+
+// 2x2: 32 input pixels per row pair -> 16 gray pixels
+template <class Layout>
+static int decimate2Neon(const uint8_t* src, size_t srcStride, int outWidth, uint8_t* dst) {
+    constexpr int bpp = Layout::bytesPerPixel;
+    int ox = 0;
+    for (; ox + 16 <= outWidth; ox += 16) {
+        const uint8_t* row0 = src + static_cast<size_t>(ox) * 2 * bpp;
+        const uint8_t* row1 = row0 + srcStride;
+
+        uint8x8_t out[2];
+        for (int half = 0; half < 2; half++) {
+            const int offset = half * 16 * bpp;
+            if constexpr (Layout::luma) {
+                uint16x8_t y = vpadalq_u8(vpaddlq_u8(load16Luma<Layout>(row0 + offset)),
+                                            load16Luma<Layout>(row1 + offset));
+                out[half] = vrshrn_n_u16(y, 2);
+            } else {
+                uint8x16_t topB, topG, topR, bottomB, bottomG, bottomR;
+                load16<Layout>(row0 + offset, topB, topG, topR);
+                load16<Layout>(row1 + offset, bottomB, bottomG, bottomR);
+
+                // Horizontal pairs, then the row below: 8 sums of 4 pixels per channel
+                uint16x8_t b = vpadalq_u8(vpaddlq_u8(topB), bottomB);
+                uint16x8_t g = vpadalq_u8(vpaddlq_u8(topG), bottomG);
+                uint16x8_t r = vpadalq_u8(vpaddlq_u8(topR), bottomR);
+
+                uint32x4_t low = vmull_n_u16(vget_low_u16(r), WEIGHT_R);
+                low = vmlal_n_u16(low, vget_low_u16(g), WEIGHT_G);
+                low = vmlal_n_u16(low, vget_low_u16(b), WEIGHT_B);
+                uint32x4_t high = vmull_n_u16(vget_high_u16(r), WEIGHT_R);
+                high = vmlal_n_u16(high, vget_high_u16(g), WEIGHT_G);
+                high = vmlal_n_u16(high, vget_high_u16(b), WEIGHT_B);
+
+                // Rounding shift by 14 + 2 (four pixels per block)
+                out[half] = vmovn_u16(vcombine_u16(vrshrn_n_u32(low, 16), vrshrn_n_u32(high, 16)));
+            }
+        }
+        vst1q_u8(dst + ox, vcombine_u8(out[0], out[1]));
+    }
+    return ox;
+}
+
+// 4x4: 32 input pixels per row over four rows -> 8 gray pixels
+template <class Layout>
+static int decimate4Neon(const uint8_t* src, size_t srcStride, int outWidth, uint8_t* dst) {
+    constexpr int bpp = Layout::bytesPerPixel;
+    int ox = 0;
+    for (; ox + 8 <= outWidth; ox += 8) {
+        uint16x4_t out[2];
+        for (int half = 0; half < 2; half++) {
+            const uint8_t* row = src + static_cast<size_t>(ox) * 4 * bpp + half * 16 * bpp;
+
+            // Pair sums over four rows stay well inside 16 bits (8 * 255)
+            if constexpr (Layout::luma) {
+                uint16x8_t y = vpaddlq_u8(load16Luma<Layout>(row));
+                for (int dy = 1; dy < 4; dy++) {
+                    y = vpadalq_u8(y, load16Luma<Layout>(row + dy * srcStride));
+                }
+                out[half] = vmovn_u32(vrshrq_n_u32(vpaddlq_u16(y), 4));
+            } else {
+                uint8x16_t pixelB, pixelG, pixelR;
+                load16<Layout>(row, pixelB, pixelG, pixelR);
+                uint16x8_t b = vpaddlq_u8(pixelB);
+                uint16x8_t g = vpaddlq_u8(pixelG);
+                uint16x8_t r = vpaddlq_u8(pixelR);
+                for (int dy = 1; dy < 4; dy++) {
+                    load16<Layout>(row + dy * srcStride, pixelB, pixelG, pixelR);
+                    b = vpadalq_u8(b, pixelB);
+                    g = vpadalq_u8(g, pixelG);
+                    r = vpadalq_u8(r, pixelR);
+                }
+
+                // Adjacent pairs once more: 4 sums of a 4x4 block per channel
+                uint32x4_t sum = vmulq_n_u32(vpaddlq_u16(r), WEIGHT_R);
+                sum = vmlaq_n_u32(sum, vpaddlq_u16(g), WEIGHT_G);
+                sum = vmlaq_n_u32(sum, vpaddlq_u16(b), WEIGHT_B);
+
+                // Rounding shift by 14 + 4 (sixteen pixels per block)
+                out[half] = vmovn_u32(vrshrq_n_u32(sum, 18));
+            }
+        }
+        vst1_u8(dst + ox, vmovn_u16(vcombine_u16(out[0], out[1])));
+    }
+    return ox;
+}
+#endif
+
+template <class Layout>
+static void decimateImage(const uint8_t* src, size_t srcStride, int width, int height,
+                            int factor, uint8_t* dst, size_t dstStride) {
+    const int shift = (factor == 4) ? 4 : 2;
+    const int outWidth = width / factor;
+    const int outHeight = height / factor;
+
+    for (int oy = 0; oy < outHeight; oy++) {
+        const uint8_t* srcRow = src + static_cast<size_t>(oy) * factor * srcStride;
+        uint8_t* dstRow = dst + static_cast<size_t>(oy) * dstStride;
+
+        int done = 0;
+#if defined(__ARM_NEON)
+        done = (factor == 4) ? decimate4Neon<Layout>(srcRow, srcStride, outWidth, dstRow)
+                                : decimate2Neon<Layout>(srcRow, srcStride, outWidth, dstRow);
+#endif
+        decimateRow<Layout>(srcRow, srcStride, factor, shift, done, outWidth, dstRow);
+    }
+}
+
+template <class Layout>
+static void convertImage(const uint8_t* src, size_t srcStride, int width, int height,
+                            uint8_t* dst, size_t dstStride, const int* rowBands, int bands,
+                            uint64_t* bandSums, uint32_t* bandHistograms) {
+    if (rowBands) {
+        std::fill(bandSums, bandSums + bands, 0);
+        if (bandHistograms) {
+            std::fill(bandHistograms, bandHistograms + bands * 256, 0);
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* srcRow = src + static_cast<size_t>(y) * srcStride;
+        uint8_t* dstRow = dst + static_cast<size_t>(y) * dstStride;
+
+        uint64_t sum = 0;
+        int done = 0;
+#if defined(__ARM_NEON)
+        done = convertRowNeon<Layout>(srcRow, width, dstRow, sum);
+#endif
+        sum += convertRow<Layout>(srcRow, done, width, dstRow);
+
+        const int band = rowBands ? rowBands[y] : -1;
+        if (band >= 0) {
+            bandSums[band] += sum;
+            if (bandHistograms) {
+                accumulateHistogram(dstRow, width, bandHistograms + band * 256);
+            }
+        }
+    }
+}
+
+template <class Layout>
+static GrayFormat grayFormat(uint32_t fourcc, const char* name) {
+    return { fourcc, name, Layout::bytesPerPixel, Layout::luma && Layout::bytesPerPixel == 1,
+                &convertImage<Layout>, &decimateImage<Layout> };
+}
+
+// Planar YUV only needs its Y plane, which is the same for both
+static const GrayFormat GRAY_FORMATS[] = {
+    grayFormat<RgbLayout<4, 0, 1, 2>>(FOURCC_XRGB8888, "XRGB8888"),
+    grayFormat<RgbLayout<4, 2, 1, 0>>(FOURCC_XBGR8888, "XBGR8888"),
+    grayFormat<RgbLayout<3, 0, 1, 2>>(FOURCC_RGB888, "RGB888"),
+    grayFormat<RgbLayout<3, 2, 1, 0>>(FOURCC_BGR888, "BGR888"),
+    grayFormat<LumaLayout<2, 0>>(FOURCC_YUYV, "YUYV"),
+    grayFormat<LumaLayout<1, 0>>(FOURCC_NV12, "NV12"),
+    grayFormat<LumaLayout<1, 0>>(FOURCC_YUV420, "YUV420"),
+};
+
+const GrayFormat* findGrayFormat(uint32_t fourcc) {
+    for (const GrayFormat &format : GRAY_FORMATS) {
+        if (format.fourcc == fourcc) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+const GrayFormat* grayFormats(size_t &count) {
+    count = sizeof(GRAY_FORMATS) / sizeof(GRAY_FORMATS[0]);
+    return GRAY_FORMATS;
+}
+
+void grayBandStats(const uint8_t* gray, size_t stride, int width, int height,
+                    const int* rowBands, int bands, uint64_t* bandSums, uint32_t* bandHistograms) {
+    std::fill(bandSums, bandSums + bands, 0);
+    if (bandHistograms) {
+        std::fill(bandHistograms, bandHistograms + bands * 256, 0);
+    }
+
+    for (int y = 0; y < height; y++) {
+        const int band = rowBands[y];
+        if (band < 0) {
+            continue;
+        }
+
+        const uint8_t* row = gray + static_cast<size_t>(y) * stride;
+        uint64_t sum = 0;
+        for (int x = 0; x < width; x++) {
+            sum += row[x];
+        }
+        bandSums[band] += sum;
+        if (bandHistograms) {
+            accumulateHistogram(row, width, bandHistograms + band * 256);
+        }
+    }
+}
+
+int otsuThreshold(const uint32_t* histogram) {
+    uint64_t total = 0;
+    double weightedTotal = 0;
+    for (int v = 0; v < 256; v++) {
+        total += histogram[v];
+        weightedTotal += static_cast<double>(v) * histogram[v];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // Maximize the between-class variance over every split point. Empty bins between
+    // the classes give a plateau; take its middle rather than hugging the dark class.
+    uint64_t background = 0;
+    double weightedBackground = 0;
+    double bestVariance = -1;
+    int bestFirst = 0;
+    int bestLast = 0;
+    for (int v = 0; v < 256; v++) {
+        background += histogram[v];
+        if (background == 0) {
+            continue;
+        }
+        const uint64_t foreground = total - background;
+        if (foreground == 0) {
+            break;
+        }
+
+        weightedBackground += static_cast<double>(v) * histogram[v];
+        const double meanBackground = weightedBackground / background;
+        const double meanForeground = (weightedTotal - weightedBackground) / foreground;
+        const double difference = meanBackground - meanForeground;
+        const double variance = static_cast<double>(background) * foreground * difference * difference;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            bestFirst = v;
+            bestLast = v;
+        } else if (variance == bestVariance) {
+            bestLast = v;
+        }
+    }
+    return (bestFirst + bestLast) / 2;
+}
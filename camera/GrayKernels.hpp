@@ -0,0 +1,56 @@
+#ifndef _GRAY_KERNELS_HPP_
+#define _GRAY_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// libcamera fourccs of the layouts below, as they sit in memory
+static constexpr uint32_t FOURCC_XRGB8888 = 0x34325258; // 'XR24': B, G, R, X
+static constexpr uint32_t FOURCC_XBGR8888 = 0x34324258; // 'XB24': R, G, B, X
+static constexpr uint32_t FOURCC_RGB888 = 0x34324752;   // 'RG24': B, G, R
+static constexpr uint32_t FOURCC_BGR888 = 0x34324742;   // 'BG24': R, G, B
+static constexpr uint32_t FOURCC_YUYV = 0x56595559;     // 'YUYV': Y0, U, Y1, V
+static constexpr uint32_t FOURCC_NV12 = 0x3231564e;     // 'NV12': Y plane, then interleaved UV
+static constexpr uint32_t FOURCC_YUV420 = 0x32315559;   // 'YU12': Y plane, then U & V planes
+
+// Hot-path pixel kernels. RGB layouts use OpenCV's BT.601 fixed-point weights, so
+// results match cv::cvtColor(COLOR_*2GRAY) to within rounding; YUV layouts take the
+// Y samples as they are. Only plane 0 is ever read: it holds all of the luma.
+
+// Kernels for one input layout, instantiated per layout at compile time & looked up
+// once when the format is configured, so nothing is dispatched per pixel
+struct GrayFormat {
+    uint32_t fourcc;
+    const char* name;
+    int bytesPerPixel; // In plane 0
+    bool inPlace;      // Plane 0 already is the gray image (planar YUV); no conversion needed
+
+    // Full resolution gray conversion that also accumulates per-band statistics while
+    // each row is still in cache: rowBands[y] names the band row y belongs to (-1 for
+    // none), bandSums[b] gets the sum of its gray values and, when bandHistograms is
+    // non-null, bandHistograms[b * 256 + v] counts pixels of value v. Rows outside every
+    // band are converted but not counted. A null rowBands converts only.
+    void (*toGrayWithStats)(const uint8_t* src, size_t srcStride, int width, int height,
+                            uint8_t* dst, size_t dstStride, const int* rowBands, int bands,
+                            uint64_t* bandSums, uint32_t* bandHistograms);
+
+    // Converts to gray & box-averages factor x factor blocks in one pass (factor 2 or 4).
+    // Writes (width / factor) x (height / factor) pixels; leftover edge pixels are ignored.
+    void (*decimateToGray)(const uint8_t* src, size_t srcStride, int width, int height,
+                            int factor, uint8_t* dst, size_t dstStride);
+};
+
+// Kernels for a fourcc, or nullptr if the layout isn't supported
+const GrayFormat* findGrayFormat(uint32_t fourcc);
+
+// Every supported layout, i.e. for tools that sweep them
+const GrayFormat* grayFormats(size_t &count);
+
+// Same statistics for an image that is already gray (i.e. a decimated one)
+void grayBandStats(const uint8_t* gray, size_t stride, int width, int height,
+                    const int* rowBands, int bands, uint64_t* bandSums, uint32_t* bandHistograms);
+
+// Otsu's threshold over a 256-bin histogram
+int otsuThreshold(const uint32_t* histogram);
+
+#endif
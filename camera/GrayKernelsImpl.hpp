@@ -0,0 +1,76 @@
+#ifndef _GRAY_KERNELS_IMPL_HPP_
+#define _GRAY_KERNELS_IMPL_HPP_
+
+// Pixel primitives shared by the generic kernels & the fixed-geometry specializations.
+// Private to the kernel translation units; not part of the processor's interface.
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 14-bit BT.601 weights, same as OpenCV's fixed-point RGB to gray
+static constexpr uint32_t WEIGHT_R = 4899;
+static constexpr uint32_t WEIGHT_G = 9617;
+static constexpr uint32_t WEIGHT_B = 1868;
+static constexpr int WEIGHT_SHIFT = 14;
+
+// Converts block sums of `shift` log2 pixels; rounding folded into the bias
+static inline uint8_t blockToGray(uint32_t sumB, uint32_t sumG, uint32_t sumR, int shift) {
+    const int totalShift = WEIGHT_SHIFT + shift;
+    return static_cast<uint8_t>((sumR * WEIGHT_R + sumG * WEIGHT_G + sumB * WEIGHT_B +
+                                    (1u << (totalShift - 1))) >> totalShift);
+}
+
+static inline void accumulateHistogram(const uint8_t* row, int width, uint32_t* histogram) {
+    for (int x = 0; x < width; x++) {
+        histogram[row[x]]++;
+    }
+}
+
+#if defined(__ARM_NEON)
+// Sum of the four lanes; vaddvq_u32 only exists on AArch64, not on 32-bit ARM
+static inline uint32_t horizontalSum(uint32x4_t lanes) {
+#if defined(__aarch64__)
+    return vaddvq_u32(lanes);
+#else
+    uint64x2_t pairs = vpaddlq_u32(lanes);
+    return static_cast<uint32_t>(vgetq_lane_u64(pairs, 0) + vgetq_lane_u64(pairs, 1));
+#endif
+}
+
+// Converts 16 pixels already split into channels & adds the gray values to `accumulated`
+static inline void convert16Neon(uint8x16_t blue, uint8x16_t green, uint8x16_t red, uint8_t* dst,
+                                    uint32x4_t &accumulated) {
+    uint16x8_t b[2] = { vmovl_u8(vget_low_u8(blue)), vmovl_u8(vget_high_u8(blue)) };
+    uint16x8_t g[2] = { vmovl_u8(vget_low_u8(green)), vmovl_u8(vget_high_u8(green)) };
+    uint16x8_t r[2] = { vmovl_u8(vget_low_u8(red)), vmovl_u8(vget_high_u8(red)) };
+
+    uint16x4_t gray[4];
+    for (int i = 0; i < 2; i++) {
+        uint32x4_t low = vmull_n_u16(vget_low_u16(r[i]), WEIGHT_R);
+        low = vmlal_n_u16(low, vget_low_u16(g[i]), WEIGHT_G);
+        low = vmlal_n_u16(low, vget_low_u16(b[i]), WEIGHT_B);
+        uint32x4_t high = vmull_n_u16(vget_high_u16(r[i]), WEIGHT_R);
+        high = vmlal_n_u16(high, vget_high_u16(g[i]), WEIGHT_G);
+        high = vmlal_n_u16(high, vget_high_u16(b[i]), WEIGHT_B);
+        gray[i * 2] = vrshrn_n_u32(low, WEIGHT_SHIFT);
+        gray[i * 2 + 1] = vrshrn_n_u32(high, WEIGHT_SHIFT);
+    }
+
+    uint8x16_t out = vcombine_u8(vmovn_u16(vcombine_u16(gray[0], gray[1])),
+                                    vmovn_u16(vcombine_u16(gray[2], gray[3])));
+    vst1q_u8(dst, out);
+    accumulated = vpadalq_u16(accumulated, vpaddlq_u8(out));
+}
+
+// Converts 16 XRGB8888 pixels & adds the gray values to `accumulated`
+static inline void convert16Neon(const uint8_t* src, uint8_t* dst, uint32x4_t &accumulated) {
+    uint8x16x4_t pixels = vld4q_u8(src);
+    convert16Neon(pixels.val[0], pixels.val[1], pixels.val[2], dst, accumulated);
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+#include "GroundMapper.hpp"
+
+#include <stdexcept>
+
+GroundMapper::GroundMapper(const std::string &path) {
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Failed to open ground calibration " + path);
+    }
+
+    cv::Mat matrix;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    storage["homography"] >> matrix;
+    storage["image_width"] >> imageWidth;
+    storage["image_height"] >> imageHeight;
+    if (matrix.rows != 3 || matrix.cols != 3 || imageWidth <= 0 || imageHeight <= 0) {
+        throw std::runtime_error("Not a valid ground calibration: " + path);
+    }
+
+    *this = GroundMapper(matrix, cv::Size(imageWidth, imageHeight));
+}
+
+GroundMapper::GroundMapper(const cv::Mat &homography, const cv::Size &imageSize)
+    : imageSize(imageSize) {
+    cv::Mat matrix;
+    homography.convertTo(matrix, CV_64F);
+    for (int i = 0; i < 9; i++) {
+        this->homography[i] = matrix.at<double>(i / 3, i % 3);
+    }
+}
+
+void GroundMapper::save(const std::string &path, const cv::Mat &homography,
+                        const cv::Size &imageSize) {
+    cv::FileStorage storage(path, cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Failed to write ground calibration " + path);
+    }
+
+    storage << "homography" << homography;
+    storage << "image_width" << imageSize.width;
+    storage << "image_height" << imageSize.height;
+    storage.release();
+}
+
+void GroundMapper::prepare(int width, int height, const std::vector<double> &rows,
+                           const LensModel* lens) {
+    this->width = width;
+    const size_t rowCount = rows.size();
+
+    // Frame pixels -> calibration pixels folded into the homography: H * diag(sx, sy, 1)
+    const double sx = static_cast<double>(imageSize.width) / width;
+    const double sy = static_cast<double>(imageSize.height) / height;
+    double scaled[9];
+    for (int r = 0; r < 3; r++) {
+        scaled[r * 3 + 0] = homography[r * 3 + 0] * sx;
+        scaled[r * 3 + 1] = homography[r * 3 + 1] * sy;
+        scaled[r * 3 + 2] = homography[r * 3 + 2];
+    }
+
+    table.resize(rowCount * width);
+    for (size_t row = 0; row < rowCount; row++) {
+        for (int x = 0; x < width; x++) {
+            cv::Point2f point = lens ? lens->undistort(static_cast<int>(row), x)
+                                     : cv::Point2f(static_cast<float>(x), static_cast<float>(rows[row]));
+            table[row * width + x] = project(scaled, point.x, point.y);
+        }
+    }
+}
+
+cv::Point2f GroundMapper::map(int rowIndex, double x) const {
+    // Interpolate between the two neighbouring columns; the ends clamp to the edge
+    const double clamped = std::clamp(x, 0.0, static_cast<double>(width - 1));
+    const int left = std::min(static_cast<int>(clamped), width - 2);
+    const float t = static_cast<float>(clamped - left);
+
+    const cv::Point2f* row = &table[static_cast<size_t>(rowIndex) * width];
+    return cv::Point2f(row[left].x + (row[left + 1].x - row[left].x) * t,
+                        row[left].y + (row[left + 1].y - row[left].y) * t);
+}
+
+cv::Point2f GroundMapper::mapPoint(const cv::Point2f &point) const {
+    return project(homography, point.x, point.y);
+}
+
+cv::Point2f GroundMapper::project(const double* h, double x, double y) const {
+    const double w = h[6] * x + h[7] * y + h[8];
+    return cv::Point2f(static_cast<float>((h[0] * x + h[1] * y + h[2]) / w),
+                        static_cast<float>((h[3] * x + h[4] * y + h[5]) / w));
+}
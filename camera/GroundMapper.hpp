@@ -0,0 +1,44 @@
+#ifndef _GROUND_MAPPER_HPP_
+#define _GROUND_MAPPER_HPP_
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "LensModel.hpp"
+
+// Maps image points onto the ground plane (mm lateral, mm ahead) through a homography
+// calibrated from a checkerboard. Instead of warping frames, the ground position of
+// every column on the rows the slices are measured on is tabulated once, so mapping
+// a centroid is a lookup & a lerp.
+class GroundMapper {
+public:
+    // Loads a calibration written by save(); throws std::runtime_error on failure
+    explicit GroundMapper(const std::string &path);
+    GroundMapper(const cv::Mat &homography, const cv::Size &imageSize);
+
+    static void save(const std::string &path, const cv::Mat &homography, const cv::Size &imageSize);
+
+    // Builds the table for the given image rows of a width x height frame. The
+    // calibration is rescaled when it was taken at a different resolution. With a
+    // lens (prepared for the same rows) each column is undistorted before projecting.
+    void prepare(int width, int height, const std::vector<double> &rows,
+                 const LensModel* lens = nullptr);
+
+    // Ground point of sub-pixel column x on prepared row rowIndex
+    cv::Point2f map(int rowIndex, double x) const;
+
+    // Exact mapping of any image point at calibration resolution, for tools
+    cv::Point2f mapPoint(const cv::Point2f &point) const;
+
+private:
+    double homography[9];
+    cv::Size imageSize;
+
+    int width = 0;
+    std::vector<cv::Point2f> table; // rowCount * width ground points
+
+    cv::Point2f project(const double* h, double x, double y) const;
+};
+
+#endif
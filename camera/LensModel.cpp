@@ -0,0 +1,73 @@
+#include "LensModel.hpp"
+
+#include <stdexcept>
+
+LensModel::LensModel(const std::string &path) {
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Failed to open lens calibration " + path);
+    }
+
+    cv::Mat matrix;
+    cv::Mat coefficients;
+    int imageWidth = 0;
+    int imageHeight = 0;
+    storage["camera_matrix"] >> matrix;
+    storage["distortion_coefficients"] >> coefficients;
+    storage["image_width"] >> imageWidth;
+    storage["image_height"] >> imageHeight;
+    if (matrix.rows != 3 || matrix.cols != 3 || coefficients.empty() ||
+        imageWidth <= 0 || imageHeight <= 0) {
+        throw std::runtime_error("Not a valid lens calibration: " + path);
+    }
+
+    *this = LensModel(matrix, coefficients, cv::Size(imageWidth, imageHeight));
+}
+
+LensModel::LensModel(const cv::Mat &cameraMatrix, const cv::Mat &distortion,
+                     const cv::Size &imageSize)
+    : imageSize(imageSize) {
+    cameraMatrix.convertTo(this->cameraMatrix, CV_64F);
+    distortion.convertTo(this->distortion, CV_64F);
+}
+
+std::vector<cv::Point2f> LensModel::undistortPoints(const std::vector<cv::Point2f> &points,
+                                                    const cv::Size &frameSize) const {
+    // Focal lengths & principal point scale with the resolution; the coefficients don't
+    cv::Mat scaled = cameraMatrix.clone();
+    const double sx = static_cast<double>(frameSize.width) / imageSize.width;
+    const double sy = static_cast<double>(frameSize.height) / imageSize.height;
+    scaled.at<double>(0, 0) *= sx;
+    scaled.at<double>(0, 2) *= sx;
+    scaled.at<double>(1, 1) *= sy;
+    scaled.at<double>(1, 2) *= sy;
+
+    // Reproject through the same matrix so the results stay in pixels
+    std::vector<cv::Point2f> undistorted;
+    cv::undistortPoints(points, undistorted, scaled, distortion, cv::Mat(), scaled);
+    return undistorted;
+}
+
+void LensModel::prepare(int width, int height, const std::vector<double> &rows) {
+    this->width = width;
+
+    std::vector<cv::Point2f> points;
+    points.reserve(rows.size() * width);
+    for (double row : rows) {
+        for (int x = 0; x < width; x++) {
+            points.emplace_back(static_cast<float>(x), static_cast<float>(row));
+        }
+    }
+    table = undistortPoints(points, cv::Size(width, height));
+}
+
+cv::Point2f LensModel::undistort(int rowIndex, double x) const {
+    // Interpolate between the two neighbouring columns; the ends clamp to the edge
+    const double clamped = std::clamp(x, 0.0, static_cast<double>(width - 1));
+    const int left = std::min(static_cast<int>(clamped), width - 2);
+    const float t = static_cast<float>(clamped - left);
+
+    const cv::Point2f* row = &table[static_cast<size_t>(rowIndex) * width];
+    return cv::Point2f(row[left].x + (row[left + 1].x - row[left].x) * t,
+                        row[left].y + (row[left + 1].y - row[left].y) * t);
+}
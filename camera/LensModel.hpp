@@ -0,0 +1,36 @@
+#ifndef _LENS_MODEL_HPP_
+#define _LENS_MODEL_HPP_
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Pinhole + radial/tangential distortion model (OpenCV's calibration output). Only the
+// rows the slices are measured on are undistorted, once, into a per-column table, so
+// correcting a centroid costs a lookup instead of a full-frame remap.
+class LensModel {
+public:
+    // Loads camera_matrix & distortion_coefficients; throws std::runtime_error on failure
+    explicit LensModel(const std::string &path);
+    LensModel(const cv::Mat &cameraMatrix, const cv::Mat &distortion, const cv::Size &imageSize);
+
+    // Exact undistortion of points in a frame of frameSize (calibration rescaled to fit)
+    std::vector<cv::Point2f> undistortPoints(const std::vector<cv::Point2f> &points,
+                                             const cv::Size &frameSize) const;
+
+    // Builds the table for the given image rows of a width x height frame
+    void prepare(int width, int height, const std::vector<double> &rows);
+
+    // Undistorted position of sub-pixel column x on prepared row rowIndex
+    cv::Point2f undistort(int rowIndex, double x) const;
+
+private:
+    cv::Mat cameraMatrix;
+    cv::Mat distortion;
+    cv::Size imageSize;
+
+    int width = 0;
+    std::vector<cv::Point2f> table; // rows * width undistorted points
+};
+
+#endif
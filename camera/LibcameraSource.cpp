@@ -0,0 +1,583 @@
+#include "LibcameraSource.hpp"
+#include "CropGeometry.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+
+// Ranges the sensor reports for the controls planControls clamps
+static SensorLimits readLimits(const libcamera::ControlInfoMap &info) {
+    SensorLimits limits;
+    auto frameDuration = info.find(&libcamera::controls::FrameDurationLimits);
+    if (frameDuration != info.end()) {
+        limits.minFrameDurationUs = frameDuration->second.min().get<int64_t>();
+        limits.maxFrameDurationUs = frameDuration->second.max().get<int64_t>();
+    }
+    auto exposureTime = info.find(&libcamera::controls::ExposureTime);
+    if (exposureTime != info.end()) {
+        limits.minExposureUs = exposureTime->second.min().get<int32_t>();
+        limits.maxExposureUs = exposureTime->second.max().get<int32_t>();
+    }
+    auto gain = info.find(&libcamera::controls::AnalogueGain);
+    if (gain != info.end()) {
+        limits.minGain = gain->second.min().get<float>();
+        limits.maxGain = gain->second.max().get<float>();
+    }
+    return limits;
+}
+
+// Plain Bayer & mono raw formats carry their depth in the name, i.e. SRGGB10_CSI2P or
+// R12. Anything else (compressed PISP_COMP1 and the like) returns 0: PixelFormatInfo
+// knows better but is internal to libcamera.
+static int rawBitDepth(const libcamera::PixelFormat &pixelFormat) {
+    const std::string name = pixelFormat.toString();
+    size_t digits = 1;
+    if (name.size() > 5 && name[0] == 'S') {
+        const std::string order = name.substr(1, 4);
+        if (order != "RGGB" && order != "GRBG" && order != "GBRG" && order != "BGGR") {
+            return 0;
+        }
+        digits = 5;
+    } else if (name.empty() || name[0] != 'R') {
+        return 0;
+    }
+
+    const size_t end = name.find_first_not_of("0123456789", digits);
+    const std::string suffix = (end == std::string::npos) ? "" : name.substr(end);
+    if (end == digits || (!suffix.empty() && suffix != "_CSI2P")) {
+        return 0;
+    }
+    const int depth = std::atoi(name.c_str() + digits);
+    return (depth >= 8 && depth <= 16) ? depth : 0;
+}
+
+static void setControls(const ControlPlan &plan, libcamera::ControlList &list) {
+    if (plan.frameDurationUs > 0) {
+        list.set(libcamera::controls::FrameDurationLimits,
+                    libcamera::Span<const int64_t, 2>({ plan.frameDurationUs, plan.frameDurationUs }));
+    }
+    if (plan.exposureUs > 0) {
+        list.set(libcamera::controls::ExposureTime, static_cast<int32_t>(plan.exposureUs));
+    }
+    if (plan.analogueGain > 0) {
+        list.set(libcamera::controls::AnalogueGain, plan.analogueGain);
+    }
+    list.set(libcamera::controls::AeEnable, plan.aeEnable);
+    list.set(libcamera::controls::AwbEnable, plan.awbEnable);
+    if (!plan.awbEnable && plan.colourGains[0] > 0) {
+        list.set(libcamera::controls::ColourGains,
+                    libcamera::Span<const float, 2>({ plan.colourGains[0], plan.colourGains[1] }));
+    }
+}
+
+LibcameraSource::LibcameraSource() {
+    // Loads the library's camera manager for camera acquisition
+    cameraManager = std::make_unique<CameraManager>();
+    cameraManager->start();
+
+    // Identifies all cameras attached to the device
+    auto attachedCameras = cameraManager->cameras();
+    if (attachedCameras.empty()) {
+        std::cerr << "No cameras were identified on the system." << std::endl;
+        cameraManager->stop();
+        exit(EXIT_FAILURE);
+    }
+
+    // Acquire only the first camera (only option we have) & put a lock on it
+    camera = attachedCameras.front();
+    if (camera->acquire() != 0) {
+        std::cerr << "Failed to acquire camera." << std::endl;
+        cameraManager->stop();
+        exit(EXIT_FAILURE);
+    }
+    std::cout << "Acquired camera: " << camera->id() << std::endl;
+}
+
+LibcameraSource::~LibcameraSource() {
+    stop();
+    freeAllBuffers();
+    camera->release();
+    camera.reset();
+    cameraManager->stop();
+}
+
+std::vector<SensorMode> LibcameraSource::enumerateModes() {
+    std::vector<SensorMode> modes;
+    std::unique_ptr<CameraConfiguration> raw = camera->generateConfiguration({ StreamRole::Raw });
+    if (!raw) {
+        return modes;
+    }
+
+    // Frame rate & crop are only reported for the configured mode, so try each in turn
+    const libcamera::StreamFormats &formats = raw->at(0).formats();
+    for (const PixelFormat &pixelFormat : formats.pixelformats()) {
+        // Formats whose depth we can't tell apart would collapse into one bogus mode
+        if (rawBitDepth(pixelFormat) == 0) {
+            continue;
+        }
+        for (const libcamera::Size &size : formats.sizes(pixelFormat)) {
+            raw->at(0).pixelFormat = pixelFormat;
+            raw->at(0).size = size;
+            if (raw->validate() == CameraConfiguration::Invalid || camera->configure(raw.get()) != 0) {
+                continue;
+            }
+
+            SensorMode mode;
+            mode.width = raw->at(0).size.width;
+            mode.height = raw->at(0).size.height;
+            mode.bitDepth = rawBitDepth(raw->at(0).pixelFormat);
+
+            // Packed & unpacked variants of one mode are the same readout
+            bool duplicate = false;
+            for (const SensorMode &known : modes) {
+                duplicate |= known.width == mode.width && known.height == mode.height &&
+                                known.bitDepth == mode.bitDepth;
+            }
+            if (duplicate) {
+                continue;
+            }
+
+            const libcamera::ControlInfoMap &info = camera->controls();
+            auto frameDuration = info.find(&libcamera::controls::FrameDurationLimits);
+            if (frameDuration != info.end()) {
+                const int64_t minDurationUs = frameDuration->second.min().get<int64_t>();
+                mode.maxFps = (minDurationUs > 0) ? 1e6 / minDurationUs : 0;
+            }
+            auto crop = info.find(&libcamera::controls::ScalerCrop);
+            if (crop != info.end()) {
+                const libcamera::Rectangle area = crop->second.max().get<libcamera::Rectangle>();
+                mode.cropX = static_cast<uint32_t>(area.x);
+                mode.cropY = static_cast<uint32_t>(area.y);
+                mode.cropWidth = area.width;
+                mode.cropHeight = area.height;
+            }
+            modes.push_back(mode);
+        }
+    }
+    return modes;
+}
+
+int LibcameraSource::configure(const uint_fast32_t width, const uint_fast32_t height,
+                                const PixelFormat pixelFormat, const StreamRole role) {
+    // libcamera won't reconfigure a camera that still has buffers allocated
+    freeAllBuffers();
+
+    std::optional<SensorMode> sensorMode;
+    if (modeRequirements.policy != SensorModeRequirements::Policy::Default) {
+        SensorModeRequirements requirements = modeRequirements;
+        requirements.outputWidth = std::max<uint32_t>(requirements.outputWidth, width);
+        requirements.outputHeight = std::max<uint32_t>(requirements.outputHeight, height);
+        requirements.minFps = std::max(requirements.minFps, exposure.fps);
+
+        const std::vector<SensorMode> modes = enumerateModes();
+        const libcamera::Size array = camera->properties().get(libcamera::properties::PixelArraySize)
+                                        .value_or(libcamera::Size());
+        const int index = selectSensorMode(modes, requirements, array.width, array.height);
+        for (size_t i = 0; i < modes.size(); i++) {
+            std::cout << (static_cast<int>(i) == index ? "* " : "  ") << "Sensor mode " << modes[i].width
+                        << "x" << modes[i].height << " " << modes[i].bitDepth << "-bit, up to "
+                        << modes[i].maxFps << " fps" << std::endl;
+        }
+        if (index >= 0) {
+            sensorMode = modes[index];
+        } else {
+            std::cerr << "No sensor mode meets the requirements; leaving the choice to libcamera" << std::endl;
+        }
+    }
+
+    // Create configuration profile for the camera; the ISP scales both outputs from
+    // the same sensor frame
+    const bool recording = recordWidth > 0 && recordHeight > 0;
+    if (recording) {
+        config = camera->generateConfiguration({ role, StreamRole::VideoRecording });
+    } else {
+        config = camera->generateConfiguration({ role });
+    }
+    if (!config) {
+        std::cerr << "Camera can't produce the requested streams" << std::endl;
+        return -EINVAL;
+    }
+    StreamConfiguration &streamConfig = config->at(0);
+    std::cout << "Default configuration is: " << streamConfig.toString() << std::endl;
+
+    // Adjust & validate the desired configuration
+    streamConfig.size.width = width;
+    streamConfig.size.height = height;
+    streamConfig.pixelFormat = pixelFormat;
+    if (bufferCount > 0) {
+        streamConfig.bufferCount = bufferCount;
+    }
+    if (recording) {
+        StreamConfiguration &recordConfig = config->at(1);
+        recordConfig.size.width = recordWidth;
+        recordConfig.size.height = recordHeight;
+        recordConfig.pixelFormat = recordPixelFormat;
+    }
+    if (sensorMode) {
+        libcamera::SensorConfiguration sensorConfig;
+        sensorConfig.bitDepth = sensorMode->bitDepth;
+        sensorConfig.outputSize = libcamera::Size(sensorMode->width, sensorMode->height);
+        config->sensorConfig = sensorConfig;
+    }
+    config->validate();
+    if (camera->configure(config.get()) != 0) {
+        std::cerr << "Failed to config camera: " << camera->id() << std::endl;
+        return -EINVAL;
+    }
+    std::cout << "Selected configuration is: " << streamConfig.toString() << std::endl;
+    if (recording) {
+        std::cout << "Selected recording stream is: " << config->at(1).toString() << std::endl;
+    }
+
+    format.fullHeight = 0;
+    format.rowOffset = 0;
+    scalerCrop.reset();
+    if (bandHeight > 0 && bandHeight < 1) {
+        int result = cropToBand(streamConfig);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    format.width = streamConfig.size.width;
+    format.height = streamConfig.size.height;
+    format.stride = streamConfig.stride;
+    format.fourcc = streamConfig.pixelFormat.fourcc();
+
+    recordingFormat = Format();
+    recordStream = nullptr;
+    if (recording) {
+        const StreamConfiguration &recordConfig = config->at(1);
+        recordingFormat.width = recordConfig.size.width;
+        recordingFormat.height = recordConfig.size.height;
+        recordingFormat.stride = recordConfig.stride;
+        recordingFormat.fourcc = recordConfig.pixelFormat.fourcc();
+        recordingFormat.fullHeight = format.fullHeight ? recordHeight : 0;
+        recordingFormat.rowOffset = format.fullHeight ? format.rowOffset * recordHeight / format.fullHeight : 0;
+        recordStream = recordConfig.stream();
+    }
+
+    // Allocate the buffers & map the memory we need for the incoming camera streams
+    allocator = std::make_unique<FrameBufferAllocator>(camera);
+
+    for (StreamConfiguration &cfg : *config) {
+        // Allocate buffers via stream inputs
+        Stream* stream = cfg.stream();
+        if (allocator->allocate(cfg.stream()) < 0) {
+            std::cerr << "Failed to allocate buffers" << std::endl;
+            freeAllBuffers();
+            return -ENOMEM;
+        }
+
+        size_t allocated = allocator->buffers(cfg.stream()).size();
+        std::cout << "Allocated " << allocated << " buffers for stream" << std::endl;
+
+        // Pre-map the buffers so we don't recursively refresh memory regions when rendering
+        // Note: Multi-plane buffering all have the same file descriptor
+        // starting at 20, increasing
+        for (const std::unique_ptr<FrameBuffer> &buffer : allocator->buffers(stream)) {
+            // Iterate through all possible plane associated with a buffer
+            // (i.e. YUV420 has 3; XRGB8888 has 1) 
+            for (unsigned int i = 0; i < buffer->planes().size(); i++) {
+                // Accounts for only YUV & XRGB8888 due to my integration for opencv.
+                // Adjustments not accounted for other pixel formats.
+                if (i == 0) {
+                    // Maps the individual plane's buffer
+                    const FrameBuffer::Plane &plane = buffer->planes()[i];
+                    
+                    void* data_ = mmap(NULL, plane.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                        plane.fd.get(), 0);
+                    if (data_ == MAP_FAILED) {
+                        const int error = errno;
+                        std::cerr << "Failed to map buffer for plane: " << std::strerror(error) << std::endl;
+                        freeAllBuffers();
+                        return -error;
+                    }
+
+                    // Store mapped buffer for later use so we don't need to loop remapping
+                    mappedBuffers[buffer.get()].push_back(
+                        libcamera::Span<uint8_t>(static_cast<uint8_t*>(data_), plane.length)
+                    );
+                }
+            }
+            // Store the stream's buffer for request
+            frameBuffers[stream].push(buffer.get());
+        }
+    }
+
+    return 0;
+}
+
+void LibcameraSource::freeAllBuffers() {
+    // Allocator first so no stream holds buffers any more, then our views of them
+    allocator.reset();
+    for (auto &[buffer, spans] : mappedBuffers) {
+        for (libcamera::Span<uint8_t> &span : spans) {
+            munmap(span.data(), span.size());
+        }
+    }
+    mappedBuffers.clear();
+    frameBuffers.clear();
+    requests.clear();
+    std::lock_guard<std::mutex> lock(recordMutex);
+    freeRecordBuffers = std::queue<FrameBuffer*>();
+}
+
+int LibcameraSource::cropToBand(StreamConfiguration &streamConfig) {
+    // The crop range is only known once the sensor mode is configured
+    const libcamera::ControlInfoMap &info = camera->controls();
+    auto cropInfo = info.find(&libcamera::controls::ScalerCrop);
+    if (cropInfo == info.end()) {
+        std::cerr << "Camera has no ScalerCrop; delivering whole frames" << std::endl;
+        return 0;
+    }
+
+    const libcamera::Rectangle maximum = cropInfo->second.max().get<libcamera::Rectangle>();
+    CropRect maxCrop;
+    maxCrop.x = maximum.x;
+    maxCrop.y = maximum.y;
+    maxCrop.width = maximum.width;
+    maxCrop.height = maximum.height;
+
+    const uint32_t fullHeight = streamConfig.size.height;
+    const BandCrop crop = planBandCrop(maxCrop, streamConfig.size.width, fullHeight, bandTop, bandHeight);
+
+    // Same width & scale, fewer rows; the recording stream keeps its own scale
+    streamConfig.size.height = crop.outputHeight;
+    if (config->size() > 1) {
+        config->at(1).size.height = recordHeight * crop.outputHeight / fullHeight;
+    }
+    config->validate();
+    if (camera->configure(config.get()) != 0) {
+        std::cerr << "Failed to config cropped stream on camera: " << camera->id() << std::endl;
+        return -EINVAL;
+    }
+    if (streamConfig.size.height != crop.outputHeight) {
+        std::cerr << "Cropped stream adjusted to " << streamConfig.size.toString()
+                    << "; slice rows may be off by the difference" << std::endl;
+    }
+
+    scalerCrop = libcamera::Rectangle(crop.scalerCrop.x, crop.scalerCrop.y,
+                                        crop.scalerCrop.width, crop.scalerCrop.height);
+    format.fullHeight = fullHeight;
+    format.rowOffset = crop.rowOffset;
+    std::cout << "Reading out rows " << crop.rowOffset << "-" << crop.rowOffset + crop.outputHeight
+                << " of " << fullHeight << " (ScalerCrop " << scalerCrop->toString() << ")" << std::endl;
+    return 0;
+}
+
+const FrameSource::Format& LibcameraSource::getFormat() const {
+    return format;
+}
+
+const FrameSource::Format& LibcameraSource::getRecordingFormat() const {
+    return recordingFormat;
+}
+
+void LibcameraSource::setBufferCount(unsigned int count) {
+    bufferCount = count;
+}
+
+void LibcameraSource::setExposure(const ExposureSettings &settings) {
+    exposure = settings;
+}
+
+void LibcameraSource::setBandOfInterest(double top, double height) {
+    bandTop = top;
+    bandHeight = height;
+}
+
+void LibcameraSource::setSensorModeRequirements(const SensorModeRequirements &requirements) {
+    modeRequirements = requirements;
+}
+
+void LibcameraSource::setRecordingStream(uint32_t width, uint32_t height, const PixelFormat &pixelFormat) {
+    recordWidth = width;
+    recordHeight = height;
+    recordPixelFormat = pixelFormat;
+}
+
+void LibcameraSource::start(FrameCallback onFrame) {
+    frameCallback = std::move(onFrame);
+    sendRequests();
+    camera->requestCompleted.connect(this, &LibcameraSource::requestComplete);
+
+    // A fixed frame duration (min = max) is what keeps the interval constant; exposure
+    // is clamped inside it
+    plan = planControls(exposure, readLimits(camera->controls()));
+    lockComputed = false;
+    libcamera::ControlList controls;
+    setControls(plan, controls);
+    if (scalerCrop) {
+        controls.set(libcamera::controls::ScalerCrop, *scalerCrop);
+    }
+    camera->start(&controls);
+    running.store(true, std::memory_order_release);
+    for (std::unique_ptr<Request>& request : requests) {
+        camera->queueRequest(request.get());
+    }
+}
+
+void LibcameraSource::stop() {
+    if (running.exchange(false, std::memory_order_acq_rel)) {
+        camera->stop();
+    }
+}
+
+void LibcameraSource::sendRequests() {
+    // Acquire the allocated buffers for streams stored in CameraConfiguration by libcamera
+    // to create the requests (we can percieve request as a promise and fullfill event).
+    // One request per processing buffer so a request held by the recorder doesn't starve
+    // the sensor; recording buffers are handed out from their pool.
+    Stream* stream = config->at(0).stream();
+    if (recordStream) {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        while (!frameBuffers[recordStream].empty()) {
+            freeRecordBuffers.push(frameBuffers[recordStream].front());
+            frameBuffers[recordStream].pop();
+        }
+    }
+
+    while (!frameBuffers[stream].empty()) {
+        std::unique_ptr<Request> request = camera->createRequest();
+        if (!request) {
+            std::cerr << "Can't create request" << std::endl;
+            throw std::runtime_error("Failed to make a request");
+        }
+        requests.push_back(std::move(request));
+
+        // Seperate the frame buffer associated with the stream
+        FrameBuffer* buffer = frameBuffers[stream].front();
+        frameBuffers[stream].pop();
+
+        if (requests.back()->addBuffer(stream, buffer) < 0) {
+            throw std::runtime_error("Failed to add buffer to request");
+        }
+        if (recordStream) {
+            std::lock_guard<std::mutex> lock(recordMutex);
+            if (!freeRecordBuffers.empty()) {
+                requests.back()->addBuffer(recordStream, freeRecordBuffers.front());
+                freeRecordBuffers.pop();
+            }
+        }
+    }
+}
+
+void LibcameraSource::requestComplete(Request* request) {
+    if (request->status() == Request::RequestCancelled) {
+        return;
+    }
+
+    // Only the first stream feeds the processor
+    FrameBuffer* recordBuffer = recordStream ? request->findBuffer(recordStream) : nullptr;
+    const FrameBuffer* buffer = request->findBuffer(config->at(0).stream());
+    if (!buffer || buffer->metadata().status != FrameMetadata::FrameSuccess) {
+        recycleRecordBuffer(recordBuffer);
+        requeueRequest(request);
+        return;
+    }
+
+    // Find the mapped buffer associated with the given FrameBuffer
+    auto item = mappedBuffers.find(const_cast<FrameBuffer*>(buffer));
+    if (item == mappedBuffers.end() || item->second.empty() || item->second[0].data() == nullptr) {
+        std::cerr << "Mapped buffer not found, cannot deliver frame" << std::endl;
+        recycleRecordBuffer(recordBuffer);
+        requeueRequest(request);
+        return;
+    }
+
+    if (plan.lockWhenConverged && !lockComputed) {
+        checkConvergence(request);
+    }
+
+    Frame frame;
+    frame.data = item->second[0].data();
+    frame.bytes = item->second[0].size();
+    frame.sequence = buffer->metadata().sequence;
+    frame.timestampNs = buffer->metadata().timestamp;
+    frame.exposureUs = request->metadata().get(libcamera::controls::ExposureTime).value_or(-1);
+    frame.cookie = reinterpret_cast<uint64_t>(request);
+    frame.stream = 0;
+    frame.recording = nullptr;
+
+    // Same exposure, other scaler output; released on its own by whoever keeps it
+    Frame recordingFrame;
+    if (recordBuffer) {
+        auto mapped = mappedBuffers.find(recordBuffer);
+        if (recordBuffer->metadata().status == FrameMetadata::FrameSuccess && mapped != mappedBuffers.end()
+                && !mapped->second.empty()) {
+            recordingFrame = frame;
+            recordingFrame.data = mapped->second[0].data();
+            recordingFrame.bytes = mapped->second[0].size();
+            recordingFrame.cookie = reinterpret_cast<uint64_t>(recordBuffer);
+            recordingFrame.stream = 1;
+            frame.recording = &recordingFrame;
+        } else {
+            recycleRecordBuffer(recordBuffer);
+        }
+    }
+    frameCallback(frame);
+}
+
+void LibcameraSource::checkConvergence(const Request* request) {
+    const libcamera::ControlList &metadata = request->metadata();
+    if (!metadata.get(libcamera::controls::AeLocked).value_or(false)) {
+        return;
+    }
+
+    const int64_t exposureUs = metadata.get(libcamera::controls::ExposureTime).value_or(0);
+    const float gain = metadata.get(libcamera::controls::AnalogueGain).value_or(0.0f);
+    float red = 0, blue = 0;
+    if (auto gains = metadata.get(libcamera::controls::ColourGains)) {
+        red = (*gains)[0];
+        blue = (*gains)[1];
+    }
+
+    locked = lockedPlan(plan, exposureUs, gain, red, blue);
+    lockComputed = true;
+    lockPending.store(true, std::memory_order_release);
+    std::cout << "Exposure locked at " << locked.exposureUs << " us, gain " << locked.analogueGain << std::endl;
+}
+
+void LibcameraSource::release(const Frame &frame) {
+    if (frame.stream == 1) {
+        recycleRecordBuffer(reinterpret_cast<FrameBuffer*>(frame.cookie));
+        return;
+    }
+    requeueRequest(reinterpret_cast<Request*>(frame.cookie));
+}
+
+void LibcameraSource::recycleRecordBuffer(FrameBuffer* buffer) {
+    if (buffer) {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        freeRecordBuffers.push(buffer);
+    }
+}
+
+void LibcameraSource::requeueRequest(Request* request) {
+    if (!running.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (!recordStream) {
+        request->reuse(Request::ReuseBuffers);
+    } else {
+        // The recording buffer may still be with the recorder: keep only the processing
+        // buffer & take whichever recording buffer is free now
+        Stream* stream = config->at(0).stream();
+        FrameBuffer* buffer = request->findBuffer(stream);
+        request->reuse(Request::Default);
+        request->addBuffer(stream, buffer);
+
+        std::lock_guard<std::mutex> lock(recordMutex);
+        if (!freeRecordBuffers.empty()) {
+            request->addBuffer(recordStream, freeRecordBuffers.front());
+            freeRecordBuffers.pop();
+        }
+    }
+    if (lockPending.exchange(false, std::memory_order_acquire)) {
+        setControls(locked, request->controls());
+    }
+    camera->queueRequest(request);
+}
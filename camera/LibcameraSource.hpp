@@ -0,0 +1,102 @@
+#ifndef _LIBCAMERA_SOURCE_HPP_
+#define _LIBCAMERA_SOURCE_HPP_
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+#include <sys/mman.h> // mmap & munmap
+
+#include "FrameSource.hpp"
+#include "SensorModes.hpp"
+
+class LibcameraSource : public FrameSource {
+public:
+    using Camera = libcamera::Camera;
+    using CameraManager = libcamera::CameraManager;
+    using CameraConfiguration = libcamera::CameraConfiguration;
+    using Stream = libcamera::Stream;
+    using StreamConfiguration = libcamera::StreamConfiguration;
+    using FrameBuffer = libcamera::FrameBuffer;
+    using FrameBufferAllocator = libcamera::FrameBufferAllocator;
+    using FrameMetadata = libcamera::FrameMetadata;
+    using Request = libcamera::Request;
+
+    LibcameraSource(); // Acquires the first camera on the system
+    ~LibcameraSource() override;
+
+    int configure(const uint_fast32_t width, const uint_fast32_t height,
+                    const PixelFormat pixelFormat, const StreamRole role) override;
+    const Format& getFormat() const override;
+    const Format& getRecordingFormat() const override;
+    void setBufferCount(unsigned int count) override;
+    void setExposure(const ExposureSettings &settings) override;
+    void setBandOfInterest(double top, double height) override;
+
+    // Picks the sensor mode on the next configure(); the output size defaults to the
+    // configured one & the requirements' minFps to the exposure settings' frame rate
+    void setSensorModeRequirements(const SensorModeRequirements &requirements);
+
+    // Also request a VideoRecording stream of this size from the ISP on the next
+    // configure(), scaled from the same exposure as the processing stream; width 0 = none
+    void setRecordingStream(uint32_t width, uint32_t height, const PixelFormat &pixelFormat);
+    void start(FrameCallback onFrame) override;
+    void stop() override;
+    void release(const Frame &frame) override;
+
+private:
+    std::shared_ptr<Camera> camera;
+    std::unique_ptr<CameraManager> cameraManager;
+    std::unique_ptr<CameraConfiguration> config;
+    std::unique_ptr<FrameBufferAllocator> allocator;
+    std::vector<std::unique_ptr<Request>> requests;
+    Format format;
+    unsigned int bufferCount = 0; // 0 = the pipeline handler's default
+    SensorModeRequirements modeRequirements;
+    double bandTop = 0;
+    double bandHeight = 0;
+    std::optional<libcamera::Rectangle> scalerCrop; // Sent with start() when cropping
+
+    // Every request carries a processing buffer, so detection sees every frame. The
+    // recording stream has fewer buffers than requests in flight while the recorder
+    // copies, so its buffers are pooled & attached to whichever request is requeued next.
+    uint32_t recordWidth = 0;
+    uint32_t recordHeight = 0;
+    PixelFormat recordPixelFormat;
+    Format recordingFormat;
+    Stream* recordStream = nullptr;
+    std::mutex recordMutex;
+    std::queue<FrameBuffer*> freeRecordBuffers;
+
+    // Controls sent with start(), and the AE/AWB lock swapped in once they converge.
+    // The lock is computed on the completion thread and attached to whichever request
+    // is requeued next, which may happen on the recorder's thread.
+    ExposureSettings exposure;
+    ControlPlan plan;
+    ControlPlan locked;
+    bool lockComputed = false;
+    std::atomic<bool> lockPending{false};
+    FrameCallback frameCallback;
+    std::atomic<bool> running{false}; // Frames released after stop() aren't requeued
+
+    // House the Span (mapped memory: 1st param = region offset of file; 2nd param = size)
+    std::map<FrameBuffer*, std::vector<libcamera::Span<uint8_t>>> mappedBuffers;
+
+    // Pair that formulate each image
+    std::map<Stream*, std::queue<FrameBuffer*>> frameBuffers;
+
+    std::vector<SensorMode> enumerateModes();
+    int cropToBand(StreamConfiguration &streamConfig);
+    void freeAllBuffers();
+    void sendRequests();
+    void requestComplete(Request* request);
+    void checkConvergence(const Request* request);
+    void requeueRequest(Request* request);
+    void recycleRecordBuffer(FrameBuffer* buffer);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef _LINE_RESULT_H
+#define _LINE_RESULT_H
+
+// Result records published by the frame processor. Plain C so camera.h can hand
+// them straight to the C side without conversion.
+
+#include <stdint.h> // uint64_t
+
+#define LINE_MAX_CANDIDATES 4
+
+typedef struct {
+    float distance; // Slice middle minus blob center, in pixels (same sign as distances)
+    float width;    // Bounding box width in pixels
+    float area;     // Contour area in pixels
+    float extent;   // Contour area over bounding box area
+} LineCandidate;
+
+typedef struct {
+    int count; // Valid entries in candidates
+    LineCandidate candidates[LINE_MAX_CANDIDATES]; // Ranked by area, largest first
+} SliceCandidates;
+
+typedef struct {
+    int present;        // 1 if a line was found in this slice of frame `sequence`
+    int refreshed;      // 1 if the slice was evaluated in the latest frame, 0 if skipped
+    float confidence;   // 0..1, combines the three terms below
+    float extent;       // Contour area over bounding box area of the main blob
+    float areaFraction; // Main blob area over slice area
+    float contrast;     // Background minus line brightness around the blob, 0..1
+    uint64_t sequence;  // Frame the slice was last measured in
+} SliceStatus;
+
+// A slice's distances together with its status, copied under one lock so the numbers
+// always belong to the measurement the status describes
+typedef struct {
+    float distancePx;   // As getLineDistancesF; left over from an earlier frame unless present
+    float distanceNorm;
+    SliceStatus status;
+} SliceResult;
+
+typedef struct {
+    int valid;       // 0 without a ground calibration or when the slice has no line
+    float lateralMm; // Right of the camera axis
+    float aheadMm;   // Ahead of the calibration reference
+} GroundPoint;
+
+#define LINE_HISTORY_MAX_SLICES 16
+
+// One processed frame as kept in the result history. Only the first
+// LINE_HISTORY_MAX_SLICES slices are recorded.
+typedef struct {
+    uint64_t sequence;       // Frame sequence number
+    uint64_t timestampNs;    // Capture time of the frame
+    int slices;              // Valid entries in the arrays below
+    uint32_t presentMask;    // Bit i set if slice i was evaluated in this frame and had a line
+    uint32_t refreshedMask;  // Bit i set if slice i was evaluated in this frame (else carried over)
+    float distances[LINE_HISTORY_MAX_SLICES];  // Pixels from the slice middle, as getLineDistancesF
+    float confidence[LINE_HISTORY_MAX_SLICES]; // As SliceStatus
+} LineHistoryRecord;
+
+#endif
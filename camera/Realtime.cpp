@@ -0,0 +1,70 @@
+#include "Realtime.hpp"
+
+#include <alloca.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <malloc.h>   // mallopt
+#include <sched.h>    // sched_param & cpu_set_t
+#include <unistd.h>   // sysconf
+#include <sys/mman.h> // mlockall
+
+int applyThreadPolicy(pthread_t thread, const ThreadPolicy &policy) {
+    sched_param param{};
+    param.sched_priority = policy.priority;
+    int result = pthread_setschedparam(thread, policy.priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (result != 0) {
+        std::cerr << "Failed to set thread priority " << policy.priority << ": "
+                    << std::strerror(result) << std::endl;
+        return -result;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (policy.cpu >= 0) {
+        CPU_SET(policy.cpu, &cpus);
+    } else {
+        const long count = sysconf(_SC_NPROCESSORS_CONF);
+        for (long cpu = 0; cpu < count && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    result = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (result != 0) {
+        std::cerr << "Failed to pin thread to CPU " << policy.cpu << ": "
+                    << std::strerror(result) << std::endl;
+        return -result;
+    }
+    return 0;
+}
+
+int lockProcessMemory() {
+    // Freed blocks stay in the heap instead of going back to the kernel via trim or munmap
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        const int error = errno;
+        std::cerr << "Failed to lock memory: " << std::strerror(error) << std::endl;
+        return -error;
+    }
+    return 0;
+}
+
+void prefaultPages(void* data, size_t bytes) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile uint8_t* bytesPtr = static_cast<volatile uint8_t*>(data);
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        bytesPtr[offset] = bytesPtr[offset];
+    }
+}
+
+void prefaultStack(size_t bytes) {
+    // A dummy frame of the requested size; alloca keeps the compiler from eliding it
+    volatile uint8_t* stack = static_cast<volatile uint8_t*>(alloca(bytes));
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        stack[offset] = 0;
+    }
+}
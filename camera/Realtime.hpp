@@ -0,0 +1,28 @@
+#ifndef _REALTIME_HPP_
+#define _REALTIME_HPP_
+
+#include <cstddef>
+#include <pthread.h>
+
+// Scheduling class & CPU placement for one thread
+struct ThreadPolicy {
+    int priority = 0; // SCHED_FIFO priority (1-99); 0 puts the thread back on SCHED_OTHER
+    int cpu = -1;     // CPU to pin to; -1 lets it run on any CPU
+};
+
+// Applies the policy to a thread. Returns 0 on success, negative errno otherwise
+// (SCHED_FIFO needs root or CAP_SYS_NICE).
+int applyThreadPolicy(pthread_t thread, const ThreadPolicy &policy);
+
+// Locks current & future pages into RAM and keeps freed heap memory mapped, so the hot
+// path neither faults pages back in nor gets fresh ones from the kernel. Returns 0 on
+// success, negative errno otherwise.
+int lockProcessMemory();
+
+// Touches every page of [data, data + bytes) so they are resident before first use
+void prefaultPages(void* data, size_t bytes);
+
+// Touches `bytes` of the calling thread's stack
+void prefaultStack(size_t bytes);
+
+#endif
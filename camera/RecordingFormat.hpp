@@ -0,0 +1,41 @@
+#ifndef _RECORDING_FORMAT_HPP_
+#define _RECORDING_FORMAT_HPP_
+
+#include <cstdint>
+
+// On-disk layout of a frame ring file written by FrameRecorder:
+//   [RecordingHeader][RecordingSlot x slotCount] ... padding ... [frame 0][frame 1]...
+// Frames start at dataOffset and are slotBytes apart (both page aligned) so each
+// frame copy lands on its own pages. The newest frame lives in slot
+// (framesWritten - 1) % slotCount; older ones wrap backwards from there.
+
+static constexpr char RECORDING_MAGIC[8] = { 'P', 'I', 'C', 'A', 'M', 'R', 'E', 'C' };
+static constexpr uint32_t RECORDING_VERSION = 1;
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t pixelFormat;   // DRM fourcc of the recorded stream
+    uint32_t frameBytes;    // Payload bytes per frame (stride * height)
+    uint32_t everyNth;      // Only every Nth completed frame is recorded
+    uint64_t slotBytes;     // Distance between two frames in the data area
+    uint64_t dataOffset;    // Offset of the first frame from the start of the file
+    uint64_t framesWritten; // Total frames committed since the file was created
+    uint64_t framesSkipped; // Frames dropped because the writer was still busy
+};
+
+// Index entry per slot. `valid` is cleared while the slot is being overwritten
+// so a reader of a crashed session never trusts a half-written frame.
+struct RecordingSlot {
+    uint64_t sequence;    // Sensor frame sequence number
+    uint64_t timestampNs; // Sensor timestamp in ns
+    int64_t exposureUs;   // Exposure time reported with the frame, -1 if unknown
+    uint32_t bytes;
+    uint32_t valid;
+};
+
+#endif
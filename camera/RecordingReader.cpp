@@ -0,0 +1,75 @@
+#include "RecordingReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap & munmap
+#include <sys/stat.h> // fstat
+
+RecordingReader::RecordingReader(const std::string &path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open recording " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(RecordingHeader)) {
+        close(fd);
+        throw std::runtime_error("Recording is too small to hold a header: " + path);
+    }
+    mappedSize = static_cast<size_t>(info.st_size);
+
+    void* data_ = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (data_ == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map recording " + path);
+    }
+    mapped = static_cast<uint8_t*>(data_);
+    header = reinterpret_cast<const RecordingHeader*>(mapped);
+
+    // Reject anything that isn't a complete recording of a version we understand: frames
+    // must fit their slots, the slot table must end before the data area and every slot
+    // must lie inside the file (divided rather than multiplied so it can't overflow)
+    const uint64_t tableEnd = sizeof(RecordingHeader) + uint64_t(header->slotCount) * sizeof(RecordingSlot);
+    if (std::memcmp(header->magic, RECORDING_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != RECORDING_VERSION ||
+        header->frameBytes > header->slotBytes ||
+        tableEnd > header->dataOffset || header->dataOffset > mappedSize ||
+        (header->slotCount > 0 && header->slotBytes > (mappedSize - header->dataOffset) / header->slotCount)) {
+        munmap(mapped, mappedSize);
+        close(fd);
+        throw std::runtime_error("Not a valid recording: " + path);
+    }
+
+    const RecordingSlot* slots =
+        reinterpret_cast<const RecordingSlot*>(mapped + sizeof(RecordingHeader));
+    const uint64_t used = std::min<uint64_t>(header->framesWritten, header->slotCount);
+    for (uint64_t i = 0; i < used; i++) {
+        const RecordingSlot &slot = slots[i];
+        if (!slot.valid || slot.bytes != header->frameBytes) {
+            continue;
+        }
+        frames.push_back({ mapped + header->dataOffset + i * header->slotBytes,
+                            slot.sequence, slot.timestampNs, slot.exposureUs });
+    }
+
+    // Slots wrap around the ring, so restore capture order from the timestamps
+    std::sort(frames.begin(), frames.end(), [](const Frame &a, const Frame &b) {
+        return a.timestampNs < b.timestampNs;
+    });
+}
+
+RecordingReader::~RecordingReader() {
+    munmap(mapped, mappedSize);
+    close(fd);
+}
+
+const RecordingHeader& RecordingReader::getHeader() const {
+    return *header;
+}
+
+const std::vector<RecordingReader::Frame>& RecordingReader::getFrames() const {
+    return frames;
+}
@@ -0,0 +1,36 @@
+#ifndef _RECORDING_READER_HPP_
+#define _RECORDING_READER_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "RecordingFormat.hpp"
+
+// Read-only view over a ring file written by FrameRecorder
+class RecordingReader {
+public:
+    struct Frame {
+        const uint8_t* data;
+        uint64_t sequence;
+        uint64_t timestampNs;
+        int64_t exposureUs;
+    };
+
+    explicit RecordingReader(const std::string &path);
+    ~RecordingReader();
+
+    const RecordingHeader& getHeader() const;
+
+    // Valid frames ordered oldest to newest
+    const std::vector<Frame>& getFrames() const;
+
+private:
+    int fd = -1;
+    uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    const RecordingHeader* header = nullptr;
+    std::vector<Frame> frames;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "ResultHistory.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+ResultHistory::ResultHistory(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    slots = std::make_unique<Slot[]>(size);
+    mask = size - 1;
+}
+
+void ResultHistory::publish(const LineHistoryRecord &record) {
+    const uint64_t number = published.load(std::memory_order_relaxed);
+    Slot &slot = slots[number & mask];
+
+    // Odd while writing; the fence keeps the record's stores after the odd mark
+    slot.sequence.store(2 * number + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.record, &record, sizeof(record));
+    slot.sequence.store(2 * number + 2, std::memory_order_release);
+    published.store(number + 1, std::memory_order_release);
+}
+
+int ResultHistory::read(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) const {
+    if (!out || maxCount <= 0) {
+        return 0;
+    }
+
+    // Newest to oldest, stopping at the first record that is too old, was already
+    // overwritten by a newer lap or changed while it was copied: everything older
+    // than it has been (or is about to be) overwritten as well
+    const uint64_t newest = published.load(std::memory_order_acquire);
+    const uint64_t oldest = (newest > mask + 1) ? newest - (mask + 1) : 0;
+    int count = 0;
+    for (uint64_t number = newest; number > oldest && count < maxCount; number--) {
+        const Slot &slot = slots[(number - 1) & mask];
+        const uint64_t expected = 2 * number;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            break;
+        }
+        std::memcpy(&out[count], &slot.record, sizeof(LineHistoryRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected ||
+            out[count].timestampNs <= sinceTimestampNs) {
+            break;
+        }
+        count++;
+    }
+
+    std::reverse(out, out + count);
+    return count;
+}
+
+size_t ResultHistory::capacity() const {
+    return mask + 1;
+}
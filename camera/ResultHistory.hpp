@@ -0,0 +1,40 @@
+#ifndef _RESULT_HISTORY_HPP_
+#define _RESULT_HISTORY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "LineResult.h"
+
+// Fixed-size ring of the latest results, written by the processing thread only and
+// read from any thread without locks or allocation. Each slot is a seqlock: its
+// sequence is odd while the writer fills it and 2 * (record number + 1) once it is
+// complete, so a reader can tell a finished record from one being overwritten
+// under it, and drops the latter instead of returning it torn.
+class ResultHistory {
+public:
+    explicit ResultHistory(size_t capacity); // Rounded up to a power of two, at least 2
+
+    // Single writer
+    void publish(const LineHistoryRecord &record);
+
+    // Copies the records with a timestamp after sinceTimestampNs, oldest first. When
+    // more than maxCount qualify the newest maxCount are copied. Returns the count.
+    int read(uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) const;
+
+    size_t capacity() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        LineHistoryRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    std::atomic<uint64_t> published{0}; // Records written so far
+};
+
+#endif
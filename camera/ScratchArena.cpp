@@ -0,0 +1,48 @@
+#include "ScratchArena.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>   // sysconf
+#include <sys/mman.h> // mmap, madvise & munmap
+
+// THP only backs naturally aligned 2 MiB extents
+static constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+ScratchArena::ScratchArena(size_t bytes, bool hugePages) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t granule = hugePages ? HUGE_PAGE : page;
+    this->bytes = (bytes + granule - 1) / granule * granule;
+
+    // Over-map by one huge page so the arena itself can start on a 2 MiB boundary
+    mappedSize = this->bytes + (hugePages ? HUGE_PAGE : 0);
+    void* data_ = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data_ == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + std::to_string(mappedSize) +
+                                    " byte scratch arena: " + std::strerror(errno));
+    }
+    mapping = static_cast<uint8_t*>(data_);
+    base = mapping;
+
+    if (hugePages) {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(mapping);
+        base = reinterpret_cast<uint8_t*>((address + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE);
+#ifdef MADV_HUGEPAGE
+        this->hugePages = madvise(base, this->bytes, MADV_HUGEPAGE) == 0;
+#endif
+        if (!this->hugePages) {
+            std::cerr << "Transparent huge pages unavailable; scratch arena uses normal pages" << std::endl;
+        }
+    }
+
+    // Writing (not just reading) is what gets private anonymous pages allocated
+    for (size_t offset = 0; offset < this->bytes; offset += page) {
+        base[offset] = 0;
+    }
+}
+
+ScratchArena::~ScratchArena() {
+    munmap(mapping, mappedSize);
+}
@@ -0,0 +1,37 @@
+#ifndef _SCRATCH_ARENA_HPP_
+#define _SCRATCH_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// One anonymous mapping that processing carves its intermediate buffers from. Every
+// page is touched when it's created, so nothing on the hot path faults a page in, and
+// it can ask for transparent huge pages to cut TLB misses on the large images.
+class ScratchArena {
+public:
+    static constexpr size_t ALIGNMENT = 64; // Cache line; also fine for NEON loads
+
+    // Throws std::runtime_error if the mapping fails. Huge pages are a hint: without
+    // THP support the arena is still usable, just backed by normal pages.
+    ScratchArena(size_t bytes, bool hugePages);
+    ~ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    uint8_t* at(size_t offset) const { return base + offset; }
+    size_t size() const { return bytes; }
+    bool hugePagesAdvised() const { return hugePages; }
+
+    // Rounds a buffer's size up so the next one starts on ALIGNMENT
+    static size_t align(size_t bytes) { return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+private:
+    uint8_t* mapping = nullptr; // What mmap returned; base may sit further in
+    size_t mappedSize = 0;
+    uint8_t* base = nullptr;
+    size_t bytes = 0;
+    bool hugePages = false;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "SensorModes.hpp"
+
+#include <cmath>
+
+// Binned modes are often cropped by a few alignment pixels; don't reject those
+static constexpr double FOV_TOLERANCE = 0.01;
+
+static bool coversFieldOfView(const SensorMode &mode, const SensorModeRequirements &requirements,
+                                uint32_t arrayWidth, uint32_t arrayHeight) {
+    if (mode.cropWidth == 0 || mode.cropHeight == 0) {
+        return true;
+    }
+
+    const double slackX = arrayWidth * FOV_TOLERANCE;
+    const double slackY = arrayHeight * FOV_TOLERANCE;
+    const double left = requirements.fovX * arrayWidth;
+    const double top = requirements.fovY * arrayHeight;
+    const double right = left + requirements.fovWidth * arrayWidth;
+    const double bottom = top + requirements.fovHeight * arrayHeight;
+
+    return mode.cropX <= left + slackX && mode.cropY <= top + slackY &&
+            mode.cropX + mode.cropWidth + slackX >= right &&
+            mode.cropY + mode.cropHeight + slackY >= bottom;
+}
+
+int selectSensorMode(const std::vector<SensorMode> &modes, const SensorModeRequirements &requirements,
+                        uint32_t arrayWidth, uint32_t arrayHeight) {
+    if (requirements.policy == SensorModeRequirements::Policy::Default) {
+        return -1;
+    }
+
+    int best = -1;
+    for (size_t i = 0; i < modes.size(); i++) {
+        const SensorMode &mode = modes[i];
+        if (mode.width < requirements.outputWidth || mode.height < requirements.outputHeight ||
+            mode.maxFps < requirements.minFps ||
+            !coversFieldOfView(mode, requirements, arrayWidth, arrayHeight)) {
+            continue;
+        }
+        if (best < 0) {
+            best = static_cast<int>(i);
+            continue;
+        }
+
+        // Frame rates come from rounded durations; treat near-equal ones as ties
+        const SensorMode &current = modes[best];
+        const double difference = mode.maxFps - current.maxFps;
+        const uint64_t pixels = static_cast<uint64_t>(mode.width) * mode.height;
+        const uint64_t currentPixels = static_cast<uint64_t>(current.width) * current.height;
+        if (difference > 0.5 || (std::abs(difference) <= 0.5 && pixels < currentPixels)) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
@@ -0,0 +1,44 @@
+#ifndef _SENSOR_MODES_HPP_
+#define _SENSOR_MODES_HPP_
+
+#include <cstdint>
+#include <vector>
+
+// One readout mode of the sensor, as enumerated from the camera
+struct SensorMode {
+    uint32_t width = 0;  // Sensor output after binning / skipping
+    uint32_t height = 0;
+    int bitDepth = 0;
+    double maxFps = 0;
+    // Part of the pixel array the mode reads out (its field of view); zero width = all
+    uint32_t cropX = 0;
+    uint32_t cropY = 0;
+    uint32_t cropWidth = 0;
+    uint32_t cropHeight = 0;
+};
+
+struct SensorModeRequirements {
+    enum class Policy {
+        Default, // Leave the choice to libcamera
+        MaxFps   // Fastest mode that satisfies everything below
+    };
+
+    Policy policy = Policy::Default;
+    uint32_t outputWidth = 0;  // The ISP may scale down but shouldn't have to scale up
+    uint32_t outputHeight = 0;
+    double minFps = 0;
+
+    // Share of the pixel array that has to stay visible, as x, y, width & height in [0, 1]
+    double fovX = 0;
+    double fovY = 0;
+    double fovWidth = 1;
+    double fovHeight = 1;
+};
+
+// Index of the mode to use, or -1 for libcamera's own choice (Default policy, or no
+// mode qualifies). Among equally fast modes the one with fewer pixels wins. Pure, so
+// it can be checked against canned mode lists.
+int selectSensorMode(const std::vector<SensorMode> &modes, const SensorModeRequirements &requirements,
+                        uint32_t arrayWidth, uint32_t arrayHeight);
+
+#endif
@@ -0,0 +1,101 @@
+#include "SliceLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SliceLayout SliceLayout::uniform(int height, int slices) {
+    SliceLayout layout;
+    layout.height = height;
+    for (int i = 0; i < slices; i++) {
+        layout.rows.emplace_back(i * height / slices, (i + 1) * height / slices);
+    }
+    return layout;
+}
+
+SliceLayout SliceLayout::fromRows(int height, const std::vector<cv::Range> &rows) {
+    int previousEnd = 0;
+    for (const cv::Range &range : rows) {
+        if (range.start < previousEnd || range.end <= range.start || range.end > height) {
+            throw std::runtime_error("Slice rows must be ordered, non-empty & inside the frame");
+        }
+        previousEnd = range.end;
+    }
+
+    SliceLayout layout;
+    layout.height = height;
+    layout.rows = rows;
+    return layout;
+}
+
+SliceLayout SliceLayout::perspective(int height, int slices, int topRow, double growth) {
+    if (slices <= 0 || topRow < 0 || height - topRow < slices || growth <= 0) {
+        throw std::runtime_error("Perspective slices need a positive growth & a row per slice");
+    }
+
+    // Heights of the geometric series h, h * growth, ... from the bottom up, filling
+    // [topRow, height); boundaries are rounded & each slice keeps at least one row
+    double total = 0;
+    for (int i = 0; i < slices; i++) {
+        total += std::pow(growth, i);
+    }
+
+    std::vector<cv::Range> rows(slices);
+    double bottom = height;
+    int end = height;
+    for (int i = 0; i < slices; i++) {
+        const int slice = slices - 1 - i;
+        bottom -= (height - topRow) * std::pow(growth, i) / total;
+        const int start = (slice == 0) ? topRow
+            : std::clamp(static_cast<int>(std::lround(bottom)), topRow + slice, end - 1);
+        rows[slice] = cv::Range(start, end);
+        end = start;
+    }
+
+    SliceLayout layout;
+    layout.height = height;
+    layout.rows = rows;
+    return layout;
+}
+
+SliceLayout SliceLayout::scaledTo(int height) const {
+    if (height == this->height) {
+        return *this;
+    }
+
+    SliceLayout layout;
+    layout.height = height;
+    for (const cv::Range &range : rows) {
+        const int start = static_cast<int>(static_cast<int64_t>(range.start) * height / this->height);
+        const int end = static_cast<int>(static_cast<int64_t>(range.end) * height / this->height);
+        layout.rows.emplace_back(start, std::max(end, start + 1));
+    }
+    return layout;
+}
+
+SliceLayout SliceLayout::croppedTo(int offset, int height) const {
+    SliceLayout layout;
+    layout.height = height;
+    for (const cv::Range &range : rows) {
+        const int start = std::clamp(range.start - offset, 0, height);
+        const int end = std::clamp(range.end - offset, start, height);
+        layout.rows.emplace_back(start, end);
+    }
+    return layout;
+}
+
+bool SliceLayout::empty() const {
+    return rows.empty();
+}
+
+int SliceLayout::size() const {
+    return static_cast<int>(rows.size());
+}
+
+int SliceLayout::getHeight() const {
+    return height;
+}
+
+const cv::Range& SliceLayout::operator[](int slice) const {
+    return rows[slice];
+}
@@ -0,0 +1,43 @@
+#ifndef _SLICE_LAYOUT_HPP_
+#define _SLICE_LAYOUT_HPP_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Frame rows covered by each slice, top to bottom, for frames of a reference height.
+// Built once at configuration time; FrameProcessor rescales it to the frames it gets.
+class SliceLayout {
+public:
+    SliceLayout() = default; // Empty: FrameProcessor splits the frame evenly
+
+    // Equal slices over the whole frame; leftover rows go to the lower slices
+    static SliceLayout uniform(int height, int slices);
+
+    // Explicit [start, end) row ranges, top to bottom, non-overlapping (gaps are allowed).
+    // Throws std::runtime_error when the ranges don't fit that description.
+    static SliceLayout fromRows(int height, const std::vector<cv::Range> &rows);
+
+    // Slices from topRow down to the bottom of the frame, each one `growth` times taller
+    // than the one below it: thin near the car, taller towards the horizon where the
+    // tape is compressed by perspective.
+    static SliceLayout perspective(int height, int slices, int topRow, double growth);
+
+    // Same layout for frames of another height
+    SliceLayout scaledTo(int height) const;
+
+    // The layout as seen in a window of `height` rows starting at row `offset`, i.e. a
+    // sensor-side crop. Slices are clipped to the window; one falling outside it becomes
+    // an empty range (start == end) so slice indices stay put but nothing is searched.
+    SliceLayout croppedTo(int offset, int height) const;
+
+    bool empty() const;
+    int size() const;
+    int getHeight() const;
+    const cv::Range& operator[](int slice) const;
+
+private:
+    int height = 0;
+    std::vector<cv::Range> rows;
+};
+
+#endif
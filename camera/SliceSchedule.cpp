@@ -0,0 +1,41 @@
+#include "SliceSchedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SliceSchedule::SliceSchedule(const std::vector<int> &periods) : periods(periods) {
+    for (int period : periods) {
+        if (period < 1) {
+            throw std::runtime_error("Slice periods must be at least one frame");
+        }
+    }
+}
+
+SliceSchedule SliceSchedule::forSpeed(int slices, double speed) {
+    // Lookahead as a position from far (0) to near (1): the faster, the further out
+    const double focus = 1.0 - std::clamp(speed, 0.0, 1.0);
+
+    std::vector<int> periods(slices);
+    for (int i = 0; i < slices; i++) {
+        const double position = (slices > 1) ? static_cast<double>(i) / (slices - 1) : focus;
+        const double offset = std::abs(position - focus);
+        periods[i] = (offset <= 1.0 / 3) ? 1 : (offset <= 2.0 / 3) ? 2 : 4;
+    }
+    return SliceSchedule(periods);
+}
+
+bool SliceSchedule::isDue(int slice, uint64_t frame) const {
+    if (periods.empty()) {
+        return true;
+    }
+    return (frame + slice) % periods[slice] == 0;
+}
+
+bool SliceSchedule::empty() const {
+    return periods.empty();
+}
+
+int SliceSchedule::size() const {
+    return static_cast<int>(periods.size());
+}
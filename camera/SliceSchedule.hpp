@@ -0,0 +1,30 @@
+#ifndef _SLICE_SCHEDULE_HPP_
+#define _SLICE_SCHEDULE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+// How often each slice is evaluated. Slice i with period p runs on the frames where
+// (frame + i) % p == 0, so slices sharing a period are staggered across frames and
+// the per-frame cost stays even rather than bunching up every p-th frame.
+class SliceSchedule {
+public:
+    SliceSchedule() = default; // Every slice, every frame
+
+    // One period (>= 1 frames) per slice; throws std::runtime_error otherwise
+    explicit SliceSchedule(const std::vector<int> &periods);
+
+    // Speed from 0 (stopped) to 1 (top speed). Slice 0 is the farthest (top) one; the
+    // slices nearest the lookahead that suits the speed run every frame, the ones
+    // furthest from it every fourth.
+    static SliceSchedule forSpeed(int slices, double speed);
+
+    bool isDue(int slice, uint64_t frame) const;
+    bool empty() const;
+    int size() const;
+
+private:
+    std::vector<int> periods;
+};
+
+#endif
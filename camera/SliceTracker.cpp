@@ -0,0 +1,62 @@
+#include "SliceTracker.hpp"
+
+SliceTracker::SliceTracker(int slices, int width, const Options &options)
+    : width(width), options(options), tracks(slices) {}
+
+// Frames since the track's last measurement, at least one
+static double framesSince(uint64_t last, uint64_t frame) {
+    return (frame > last) ? static_cast<double>(frame - last) : 1.0;
+}
+
+cv::Range SliceTracker::searchWindow(int slice, uint64_t frame) const {
+    const Track &track = tracks[slice];
+    if (track.hits < options.hitsToLock) {
+        return cv::Range(0, width);
+    }
+
+    // Widen the window with the motion expected since then so a fast sweep doesn't escape it
+    const double motion = track.velocity * framesSince(track.frame, frame);
+    double predicted = track.x + motion;
+    int halfWindow = options.minHalfWindow +
+                        static_cast<int>(options.velocityMargin * std::abs(motion));
+    int start = std::clamp(static_cast<int>(predicted) - halfWindow, 0, width);
+    int end = std::clamp(static_cast<int>(predicted) + halfWindow, 0, width);
+
+    // Prediction ran off the image; the line is better found by a full search
+    if (end - start < options.minHalfWindow) {
+        return cv::Range(0, width);
+    }
+    return cv::Range(start, end);
+}
+
+void SliceTracker::update(int slice, uint64_t frame, bool found, double centerX) {
+    Track &track = tracks[slice];
+    const double frames = framesSince(track.frame, frame);
+    track.frame = frame;
+    if (!found) {
+        track.hits = 0;
+        track.velocity = 0;
+        return;
+    }
+
+    if (track.hits == 0) {
+        // Fresh acquisition: nothing to predict from yet
+        track.x = centerX;
+        track.velocity = 0;
+    } else {
+        // The residual built up over all the frames since, so it corrects velocity per frame
+        double predicted = track.x + track.velocity * frames;
+        double residual = centerX - predicted;
+        track.x = predicted + options.alpha * residual;
+        track.velocity += options.beta * residual / frames;
+    }
+    if (track.hits < options.hitsToLock) {
+        track.hits++;
+    }
+}
+
+void SliceTracker::reset() {
+    for (Track &track : tracks) {
+        track = Track();
+    }
+}
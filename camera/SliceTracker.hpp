@@ -0,0 +1,45 @@
+#ifndef _SLICE_TRACKER_HPP_
+#define _SLICE_TRACKER_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Alpha-beta tracker per slice. Predicts where the line will be in the next frame
+// so FrameProcessor only thresholds & searches a window around it; hands back the
+// full slice width until the track is confident again. Velocity is per frame, not per
+// update, so slices the schedule evaluates only every few frames predict just as far.
+class SliceTracker {
+public:
+    struct Options {
+        double alpha = 0.6;        // Position correction gain
+        double beta = 0.2;         // Velocity correction gain
+        int minHalfWindow = 32;    // Pixels either side of the prediction
+        double velocityMargin = 2; // Extra half-width per px/frame of estimated motion
+        int hitsToLock = 2;        // Consecutive hits before the window is narrowed
+    };
+
+    SliceTracker(int slices, int width, const Options &options);
+
+    // Columns to search in the slice in frame `frame` (any counter that steps once per frame)
+    cv::Range searchWindow(int slice, uint64_t frame) const;
+
+    // Feed the measurement for that frame (found == false when the line was lost)
+    void update(int slice, uint64_t frame, bool found, double centerX);
+
+    void reset();
+
+private:
+    struct Track {
+        double x = 0;
+        double velocity = 0; // Pixels per frame
+        int hits = 0;
+        uint64_t frame = 0;  // Of the last measurement
+    };
+
+    int width;
+    Options options;
+    std::vector<Track> tracks;
+};
+
+#endif
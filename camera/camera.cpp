@@ -1,18 +1,151 @@
 #include "camera.h"
 #include "CameraSensor.hpp"
+#include "LibcameraSource.hpp"
+
+void cameraDefaultOptions(CameraOptions* options) {
+    if (!options) {
+        return;
+    }
+
+    *options = CameraOptions{};
+    options->width = 640;
+    options->height = 480;
+    options->pixelFormat = CAMERA_FORMAT_XRGB8888;
+    options->role = CAMERA_ROLE_RAW;
+    options->slices = 5;
+    options->meanIntensityMult = 0.95f;
+    options->minThreshold = 90;
+    options->maxThreshold = 170;
+    options->centroidMode = CENTROID_CONTOUR;
+    options->processingCpu = -1;
+    options->debug = 1;
+}
 
 CameraHandle* cameraInit() {
-    CameraSensor* camera = new CameraSensor();
-    
+    CameraOptions options;
+    cameraDefaultOptions(&options);
+    return cameraInitEx(&options);
+}
+
+static libcamera::StreamRole toStreamRole(CameraStreamRole role) {
+    switch (role) {
+        case CAMERA_ROLE_STILL_CAPTURE: return libcamera::StreamRole::StillCapture;
+        case CAMERA_ROLE_VIDEO_RECORDING: return libcamera::StreamRole::VideoRecording;
+        case CAMERA_ROLE_VIEWFINDER: return libcamera::StreamRole::Viewfinder;
+        default: return libcamera::StreamRole::Raw;
+    }
+}
+
+static libcamera::PixelFormat toPixelFormat(CameraPixelFormat format) {
+    switch (format) {
+        case CAMERA_FORMAT_YUV420: return libcamera::formats::YUV420;
+        case CAMERA_FORMAT_XBGR8888: return libcamera::formats::XBGR8888;
+        case CAMERA_FORMAT_RGB888: return libcamera::formats::RGB888;
+        case CAMERA_FORMAT_BGR888: return libcamera::formats::BGR888;
+        case CAMERA_FORMAT_YUYV: return libcamera::formats::YUYV;
+        case CAMERA_FORMAT_NV12: return libcamera::formats::NV12;
+        default: return libcamera::formats::XRGB8888;
+    }
+}
+
+// Everything after the stream is configured; returns 0 or the first negative errno
+static int applyOptions(CameraSensor* camera, const CameraOptions* options) {
+    int result = 0;
+    if (options->perspectiveGrowth > 0) {
+        result = camera->setPerspectiveSlices(options->height, options->perspectiveTopRow,
+                                                options->perspectiveGrowth);
+    }
+    if (result == 0 && options->lensCalibration) {
+        result = camera->loadLensCalibration(options->lensCalibration);
+    }
+    if (result == 0 && options->groundCalibration) {
+        result = camera->loadGroundCalibration(options->groundCalibration);
+    }
+    if (result != 0) {
+        return result;
+    }
+
+    if (options->deadlines) {
+        camera->enableDeadlines(options->fps);
+    }
+
+    if (options->processingPriority > 0 || options->processingCpu >= 0) {
+        ThreadPolicy policy;
+        policy.priority = options->processingPriority;
+        policy.cpu = options->processingCpu;
+        result = camera->setThreadPolicy(CameraSensor::ThreadRole::Processing, policy);
+    }
+    if (result == 0 && options->lockMemory) {
+        result = camera->lockMemory();
+    }
+    return result;
+}
+
+CameraHandle* cameraInitEx(const CameraOptions* options) {
+    if (!options) {
+        std::cerr << "No camera options given" << std::endl;
+        return NULL;
+    }
+    if (options->width == 0 || options->height == 0 || options->slices <= 0 ||
+        options->minThreshold > options->maxThreshold || options->fps < 0 ||
+        options->exposureUs < 0 || options->analogueGain < 0 ||
+        options->bandTop < 0 || options->bandHeight < 0 || options->bandTop + options->bandHeight > 1 ||
+        (options->recordWidth == 0) != (options->recordHeight == 0) ||
+        (options->deadlines && options->fps <= 0)) {
+        std::cerr << "Invalid camera options" << std::endl;
+        return NULL;
+    }
+    if (options->pixelFormat < CAMERA_FORMAT_XRGB8888 || options->pixelFormat > CAMERA_FORMAT_NV12) {
+        std::cerr << "Unsupported pixel format " << options->pixelFormat << std::endl;
+        return NULL;
+    }
+
+    auto source = std::make_unique<LibcameraSource>();
+    source->setBufferCount(options->bufferCount);
+    ExposureSettings exposure;
+    exposure.fps = options->fps;
+    exposure.exposureUs = options->exposureUs;
+    exposure.analogueGain = options->analogueGain;
+    exposure.lockWhenConverged = options->lockExposure != 0;
+    source->setExposure(exposure);
+
+    SensorModeRequirements modeRequirements;
+    if (options->sensorMode == CAMERA_MODE_MAX_FPS) {
+        modeRequirements.policy = SensorModeRequirements::Policy::MaxFps;
+    }
+    if (options->fieldOfView.width > 0 && options->fieldOfView.height > 0) {
+        modeRequirements.fovX = options->fieldOfView.x;
+        modeRequirements.fovY = options->fieldOfView.y;
+        modeRequirements.fovWidth = options->fieldOfView.width;
+        modeRequirements.fovHeight = options->fieldOfView.height;
+    }
+    source->setSensorModeRequirements(modeRequirements);
+    source->setBandOfInterest(options->bandTop, options->bandHeight);
+    source->setRecordingStream(options->recordWidth, options->recordHeight, libcamera::formats::XRGB8888);
+    auto processor = std::make_unique<FrameProcessor>(options->slices, options->meanIntensityMult,
+                                                        options->minThreshold, options->maxThreshold,
+                                                        options->debug != 0);
+    CameraSensor* camera = new CameraSensor(std::move(source), std::move(processor));
+    camera->setCentroidMode(options->centroidMode == CENTROID_INTENSITY_WEIGHTED
+                            ? FrameProcessor::CentroidMode::IntensityWeighted
+                            : FrameProcessor::CentroidMode::Contour);
+
+    if (options->historyLength > 0) {
+        camera->setHistoryLength(options->historyLength);
+    }
+
+    // Before configuring, so the scratch arena is only built once
+    if (options->hugePages) {
+        camera->useHugePages(true);
+    }
+
     // Configure camera with desired dimension, color format, & type of stream
     // All pixel format: https://libcamera.org/api-html/formats_8h_source.html
-    // WARNING: OpenCV takes only RGB type format. YUV420, etc will require additional conversion
-    const uint_fast32_t width = 640;
-    const uint_fast32_t height = 480;
-    const libcamera::PixelFormat pixelFormat = libcamera::formats::XRGB8888;
-    const libcamera::StreamRole role = libcamera::StreamRole::Raw;
-    
-    int result = camera->configCamera(width, height, pixelFormat, role);
+    int result = camera->configCamera(options->width, options->height, toPixelFormat(options->pixelFormat),
+                                        toStreamRole(options->role));
+    if (result == 0) {
+        result = applyOptions(camera, options);
+    }
     if (result != 0) {
         delete camera;
         return NULL;
@@ -37,6 +170,17 @@ void runCamera(CameraHandle* handle) {
     }
 }
 
+int cameraEnableRecording(CameraHandle* handle, const char* path, unsigned int slotCount,
+                            unsigned int everyNth) {
+    if (!handle || !path) {
+        std::cerr << "No camera handle or recording path found" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->enableRecording(path, slotCount, everyNth);
+}
+
 int* getLineDistances(CameraHandle* handle) {
     if (!handle) {
         std::cerr << "No camera handle found" << std::endl;
@@ -47,6 +191,254 @@ int* getLineDistances(CameraHandle* handle) {
     return camera->getDistances();
 } 
 
+int getLineDistancesF(CameraHandle* handle, float* pixels, float* normalized, int maxSlices) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+    if (maxSlices <= 0 || (!pixels && !normalized)) {
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getDistancesF(pixels, normalized, maxSlices);
+}
+
+int getLineCandidates(CameraHandle* handle, SliceCandidates* out, int maxSlices) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+    if (maxSlices <= 0 || !out) {
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getCandidates(out, maxSlices);
+}
+
+int getLineStatus(CameraHandle* handle, SliceStatus* out, int maxSlices) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+    if (maxSlices <= 0 || !out) {
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getStatus(out, maxSlices);
+}
+
+int getLineSnapshot(CameraHandle* handle, SliceResult* out, int maxSlices) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+    if (maxSlices <= 0 || !out) {
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getSnapshot(out, maxSlices);
+}
+
+int getLineHistory(CameraHandle* handle, uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getHistory(sinceTimestampNs, out, maxCount);
+}
+
+void cameraSetCentroidMode(CameraHandle* handle, CameraCentroidMode mode) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    camera->setCentroidMode(mode == CENTROID_INTENSITY_WEIGHTED
+                            ? FrameProcessor::CentroidMode::IntensityWeighted
+                            : FrameProcessor::CentroidMode::Contour);
+}
+
+int cameraSetSlicePeriods(CameraHandle* handle, const int* periods, int count) {
+    if (!handle || !periods || count <= 0) {
+        std::cerr << "No camera handle or slice periods given" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->setSlicePeriods(std::vector<int>(periods, periods + count));
+}
+
+void cameraSetSpeed(CameraHandle* handle, float speed) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    camera->setSpeed(speed);
+}
+
+int cameraSetThreadPolicy(CameraHandle* handle, CameraThreadRole role, int priority, int cpu) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return -EINVAL;
+    }
+
+    ThreadPolicy policy;
+    policy.priority = priority;
+    policy.cpu = cpu;
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->setThreadPolicy(role == CAMERA_THREAD_RECORDER ? CameraSensor::ThreadRole::Recorder
+                                                                  : CameraSensor::ThreadRole::Processing,
+                                   policy);
+}
+
+int cameraGetThreadPolicyResult(CameraHandle* handle) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getProcessingPolicyResult();
+}
+
+int cameraSetCallerThreadPolicy(int priority, int cpu) {
+    ThreadPolicy policy;
+    policy.priority = priority;
+    policy.cpu = cpu;
+    return applyThreadPolicy(pthread_self(), policy);
+}
+
+int cameraLockMemory(CameraHandle* handle) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->lockMemory();
+}
+
+int cameraUseHugePages(CameraHandle* handle, int enabled) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->useHugePages(enabled != 0);
+}
+
+int cameraGetMemoryStats(CameraHandle* handle, CameraMemoryStats* out) {
+    if (!handle || !out) {
+        std::cerr << "No camera handle or output given" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    FrameProcessor::MemoryStats stats = camera->getMemoryStats();
+    out->arenaBytes = stats.arenaBytes;
+    out->hugePages = stats.hugePages ? 1 : 0;
+    out->frames = stats.frames;
+    out->minorFaults = stats.minorFaults;
+    out->majorFaults = stats.majorFaults;
+    out->lastMinorFaults = stats.lastMinorFaults;
+    out->lastMajorFaults = stats.lastMajorFaults;
+    return 0;
+}
+
+void cameraEnableDeadlines(CameraHandle* handle, float fps) {
+    if (!handle || fps <= 0) {
+        std::cerr << "No camera handle or frame rate given" << std::endl;
+        return;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    camera->enableDeadlines(fps);
+}
+
+int cameraGetDeadlineStats(CameraHandle* handle, CameraDeadlineStats* out) {
+    if (!handle || !out) {
+        std::cerr << "No camera handle or output given" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    DeadlineGovernor::Stats stats = camera->getDeadlineStats();
+    out->budgetNs = stats.budgetNs;
+    out->frames = stats.frames;
+    out->misses = stats.misses;
+    out->stepsDown = stats.stepsDown;
+    out->stepsUp = stats.stepsUp;
+    out->lastNs = stats.lastNs;
+    out->level = static_cast<CameraDegradationLevel>(stats.level);
+    return 0;
+}
+
+int cameraSetSliceRows(CameraHandle* handle, const CameraSliceRows* rows, int count, int frameHeight) {
+    if (!handle || !rows || count <= 0) {
+        std::cerr << "No camera handle or slice rows given" << std::endl;
+        return -EINVAL;
+    }
+
+    std::vector<cv::Range> ranges;
+    for (int i = 0; i < count; i++) {
+        ranges.emplace_back(rows[i].start, rows[i].end);
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->setSliceRows(frameHeight, ranges);
+}
+
+int cameraSetPerspectiveSlices(CameraHandle* handle, int frameHeight, int topRow, float growth) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->setPerspectiveSlices(frameHeight, topRow, growth);
+}
+
+int cameraLoadLensCalibration(CameraHandle* handle, const char* path) {
+    if (!handle || !path) {
+        std::cerr << "No camera handle or calibration path given" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->loadLensCalibration(path);
+}
+
+int cameraLoadGroundCalibration(CameraHandle* handle, const char* path) {
+    if (!handle || !path) {
+        std::cerr << "No camera handle or calibration path given" << std::endl;
+        return -EINVAL;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->loadGroundCalibration(path);
+}
+
+int getLineGroundPoints(CameraHandle* handle, GroundPoint* out, int maxSlices) {
+    if (!handle) {
+        std::cerr << "No camera handle found" << std::endl;
+        return 0;
+    }
+
+    CameraSensor* camera = static_cast<CameraSensor*>(handle);
+    return camera->getGroundPoints(out, maxSlices);
+}
+
 void cameraTerminate(CameraHandle* handle) {
     if (!handle) {
         std::cerr << "Camera handle is null!" << std::endl;
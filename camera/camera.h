@@ -5,15 +5,245 @@
 #include <stdlib.h> // EXIT_FAILURE
 #include <stddef.h> // size_t
 
+#include "LineResult.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef void CameraHandle; // Intermediate for C compatibility
 
+typedef struct {
+    int start; // First frame row of the slice
+    int end;   // One past its last row
+} CameraSliceRows;
+
+typedef enum {
+    CAMERA_THREAD_PROCESSING = 0, // Delivers & processes frames (libcamera's completion thread)
+    CAMERA_THREAD_RECORDER = 1    // Writes recorded frames to the ring file
+} CameraThreadRole;
+
+typedef enum {
+    CAMERA_LEVEL_FULL = 0,
+    CAMERA_LEVEL_NO_MORPHOLOGY = 1,  // Skips the closing pass after thresholding
+    CAMERA_LEVEL_DECIMATED = 2,      // Searches a half resolution copy
+    CAMERA_LEVEL_REDUCED_SLICES = 3, // Each slice only every other frame
+    CAMERA_LEVEL_NO_OVERLAY = 4      // No debug drawing or preview window
+} CameraDegradationLevel;
+
+typedef struct {
+    uint64_t budgetNs;  // Frame interval processing has to fit in
+    uint64_t frames;    // Frames timed
+    uint64_t misses;    // Frames that overran the budget
+    uint64_t stepsDown; // Level changes towards cheaper processing
+    uint64_t stepsUp;   // Level changes back towards full quality
+    uint64_t lastNs;    // Processing time of the latest frame
+    CameraDegradationLevel level;
+} CameraDeadlineStats;
+
+typedef struct {
+    uint64_t arenaBytes;      // Prefaulted scratch all intermediate images live in
+    int hugePages;            // Arena advised onto transparent huge pages
+    uint64_t frames;
+    uint64_t minorFaults;     // Page faults taken while processing, all frames
+    uint64_t majorFaults;
+    uint64_t lastMinorFaults; // Same, latest frame only; should stay 0 after the first
+    uint64_t lastMajorFaults;
+} CameraMemoryStats;
+
+typedef enum {
+    CENTROID_CONTOUR = 0,           // Centroid of the largest contour (default)
+    CENTROID_INTENSITY_WEIGHTED = 1 // Sub-pixel, darkness-weighted centroid
+} CameraCentroidMode;
+
+typedef enum {
+    CAMERA_MODE_DEFAULT = 0, // libcamera picks the sensor mode from the output size
+    CAMERA_MODE_MAX_FPS = 1  // Fastest mode covering the output size, fps & field of view
+} CameraModePolicy;
+
+// Part of the sensor's pixel array; every field is a share in [0, 1]
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+} CameraRegion;
+
+typedef enum {
+    CAMERA_FORMAT_XRGB8888 = 0,
+    CAMERA_FORMAT_YUV420 = 1,  // Processed on the Y plane in place; no conversion at all
+    CAMERA_FORMAT_XBGR8888 = 2,
+    CAMERA_FORMAT_RGB888 = 3,
+    CAMERA_FORMAT_BGR888 = 4,
+    CAMERA_FORMAT_YUYV = 5,    // Gray from the Y samples; no debug preview
+    CAMERA_FORMAT_NV12 = 6     // Like YUV420
+} CameraPixelFormat;
+
+typedef enum {
+    CAMERA_ROLE_RAW = 0,
+    CAMERA_ROLE_STILL_CAPTURE = 1,
+    CAMERA_ROLE_VIDEO_RECORDING = 2,
+    CAMERA_ROLE_VIEWFINDER = 3
+} CameraStreamRole;
+
+// Everything cameraInit hardcodes, plus the settings that otherwise need a call each
+// between cameraInit & runCamera. Start from cameraDefaultOptions and change fields.
+typedef struct {
+    // Stream
+    unsigned int width;
+    unsigned int height;
+    CameraPixelFormat pixelFormat;
+    CameraStreamRole role;
+    unsigned int bufferCount; // 0 = libcamera's default
+    float fps;                // 0 = sensor default; otherwise the frame duration is fixed
+    int exposureUs;           // Fixed shutter (capped at 1/fps); 0 = automatic
+    float analogueGain;       // Fixed gain; 0 = automatic. Both fixed turns AE off.
+    int lockExposure;         // Freeze AE & AWB once they first converge
+    CameraModePolicy sensorMode;
+    CameraRegion fieldOfView; // Must stay visible under CAMERA_MODE_MAX_FPS; zero size = whole array
+    float bandTop;            // Only rows [bandTop, bandTop + bandHeight) (shares of the frame) are
+    float bandHeight;         // read out via ScalerCrop, at full scale; 0 height = whole frame.
+                              // Slice rows & calibrations stay in uncropped frame rows;
+                              // a perspective slice wholly outside the band fails init.
+    unsigned int recordWidth; // Second XRGB8888 stream from the ISP for cameraEnableRecording,
+    unsigned int recordHeight;// so detection never touches it; 0 = record the processing stream
+
+    // Line detection
+    int slices;
+    float meanIntensityMult;  // Threshold = slice mean * this, clamped to the range below
+    int minThreshold;
+    int maxThreshold;
+    CameraCentroidMode centroidMode;
+    int perspectiveTopRow;    // Used when perspectiveGrowth > 0 (see cameraSetPerspectiveSlices)
+    float perspectiveGrowth;  // 0 = even slices
+    const char* lensCalibration;   // NULL = none
+    const char* groundCalibration; // NULL = none
+    int deadlines;            // Degrade processing when frames overrun 1/fps (needs fps)
+    unsigned int historyLength; // Frames kept for getLineHistory; 0 = 128
+
+    // Real-time
+    int processingPriority;   // SCHED_FIFO priority of the processing thread, 0 = SCHED_OTHER
+    int processingCpu;        // -1 = any
+    int hugePages;            // Scratch arena on transparent huge pages
+    int lockMemory;
+
+    int debug;                // Overlay & preview window
+} CameraOptions;
+
+// Fills in what cameraInit uses: 640x480 XRGB8888 raw stream, 5 slices, 0.95 * mean
+// thresholds clamped to [90, 170], debug window on, nothing else enabled
+void cameraDefaultOptions(CameraOptions* options);
+
 CameraHandle* cameraInit(); // void indicate fatal error
+
+// Like cameraInit with every setting from options. Returns NULL if an option is out of
+// range or any step (configuration, calibration loading, thread policy...) fails.
+CameraHandle* cameraInitEx(const CameraOptions* options);
 void runCamera(CameraHandle* handle);
+
+// Record every Nth raw frame into a preallocated ring file of slotCount frames.
+// Must be called before runCamera. Returns 0 on success, negative errno otherwise.
+int cameraEnableRecording(CameraHandle* handle, const char* path, unsigned int slotCount,
+                            unsigned int everyNth);
+
 int* getLineDistances(CameraHandle* handle);
+
+// Copies the latest per-slice distances as floats: pixels from the slice middle and
+// normalized to [-1, 1]. Either output may be NULL. Returns the number of slices copied,
+// 0 when maxSlices <= 0 or there is nowhere to copy to (same for the getters below).
+int getLineDistancesF(CameraHandle* handle, float* pixels, float* normalized, int maxSlices);
+
+// Copies up to LINE_MAX_CANDIDATES blobs per slice, largest first, so forks, crossings
+// and parallel lines can be told apart. Returns the number of slices copied.
+int getLineCandidates(CameraHandle* handle, SliceCandidates* out, int maxSlices);
+
+// Copies each slice's line-present flag, confidence and the frame it was measured in.
+// Distances of slices with present == 0 are left over from an earlier frame.
+int getLineStatus(CameraHandle* handle, SliceStatus* out, int maxSlices);
+
+// Copies distances and status of every slice in one go, so a frame finishing between
+// getLineDistancesF and getLineStatus can't pair one slice's distance with another
+// measurement's flags. Returns the number of slices copied.
+int getLineSnapshot(CameraHandle* handle, SliceResult* out, int maxSlices);
+
+// Copies the results of frames captured after sinceTimestampNs (0 = every retained
+// frame), oldest first; if more qualify, the newest maxCount. Timestamps are the
+// sensor's, in ns. Takes no locks & allocates nothing, so it is safe from a control
+// loop; a record the processing thread overwrites mid-copy is left out, never torn.
+// Returns the number of records copied.
+int getLineHistory(CameraHandle* handle, uint64_t sinceTimestampNs, LineHistoryRecord* out, int maxCount);
+
+// Selects how the line center is computed in each slice. Must be called before runCamera.
+void cameraSetCentroidMode(CameraHandle* handle, CameraCentroidMode mode);
+
+// Evaluates slice i only every periods[i] frames (staggered so the load stays even).
+// Skipped slices keep their last results with refreshed == 0 in getLineStatus.
+// May be called while running. Returns 0 on success, negative errno otherwise.
+int cameraSetSlicePeriods(CameraHandle* handle, const int* periods, int count);
+
+// Picks the periods from the current speed (0 stopped .. 1 top speed): near slices
+// every frame when slow, far ones when fast. May be called every control cycle.
+void cameraSetSpeed(CameraHandle* handle, float speed);
+
+// Runs one of the library's threads at SCHED_FIFO priority (1-99, 0 = SCHED_OTHER) and
+// pins it to cpu (-1 = any). The processing thread picks it up with its next frame.
+// Returns 0 on success, negative errno otherwise (real-time priorities need root).
+int cameraSetThreadPolicy(CameraHandle* handle, CameraThreadRole role, int priority, int cpu);
+
+// Whether the processing thread's policy took: -EINPROGRESS until its next frame,
+// then 0 or the negative errno applying it failed with
+int cameraGetThreadPolicyResult(CameraHandle* handle);
+
+// Same for the calling thread, i.e. the application's own control loop
+int cameraSetCallerThreadPolicy(int priority, int cpu);
+
+// Prefaults the processing scratch buffers and mlockall()s the process so the hot path
+// never page faults. Call after cameraInit and before runCamera.
+// Returns 0 on success, negative errno otherwise.
+int cameraLockMemory(CameraHandle* handle);
+
+// Rebuilds the processing scratch arena on transparent huge pages (enabled != 0) or
+// normal ones. Call after cameraInit and before cameraLockMemory & runCamera.
+// Returns 0 on success, negative errno otherwise.
+int cameraUseHugePages(CameraHandle* handle, int enabled);
+
+// Copies the scratch arena size and the page faults taken inside frame processing,
+// so a change that brings allocation back onto the hot path shows up. Returns 0, or
+// negative errno.
+int cameraGetMemoryStats(CameraHandle* handle, CameraMemoryStats* out);
+
+// Times every frame against 1/fps. After repeated overruns processing steps down one
+// CameraDegradationLevel at a time (each level keeps the savings of the ones before),
+// and steps back up after a run of frames with headroom. May be called while running:
+// processing restarts at full quality with the next frame.
+void cameraEnableDeadlines(CameraHandle* handle, float fps);
+
+// Copies the deadline counters and current level. Returns 0, or negative errno.
+int cameraGetDeadlineStats(CameraHandle* handle, CameraDeadlineStats* out);
+
+// Replaces the even split with explicit row ranges (one per slice, top to bottom) for
+// frames frameHeight rows tall; other heights are scaled. Must be called before
+// runCamera. Returns 0 on success, negative errno otherwise (-EINVAL also when a slice
+// lies wholly outside the band of interest).
+int cameraSetSliceRows(CameraHandle* handle, const CameraSliceRows* rows, int count, int frameHeight);
+
+// Lays the slices out from topRow to the bottom of the frame, each growth times taller
+// than the one below it, so near slices are thin and far ones tall. Same rules as above.
+int cameraSetPerspectiveSlices(CameraHandle* handle, int frameHeight, int topRow, float growth);
+
+// Loads camera_matrix & distortion_coefficients (OpenCV calibration output) so float
+// distances, candidates and ground points are corrected for lens distortion.
+// Must be called before runCamera. Returns 0 on success, negative errno otherwise.
+int cameraLoadLensCalibration(CameraHandle* handle, const char* path);
+
+// Loads a homography written by the calibrate_ground tool so slice centroids are also
+// published in ground-plane millimetres. Must be called before runCamera.
+// Returns 0 on success, negative errno otherwise.
+int cameraLoadGroundCalibration(CameraHandle* handle, const char* path);
+
+// Copies each slice's centroid on the ground plane. Returns the number of slices copied.
+int getLineGroundPoints(CameraHandle* handle, GroundPoint* out, int maxSlices);
+
 void cameraTerminate(CameraHandle* handle);
 
 #ifdef __cplusplus
@@ -0,0 +1,37 @@
+#ifndef _CHECKS_HPP_
+#define _CHECKS_HPP_
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Tally for the table-driven checkers: prints every case, flags the wrong ones and
+// turns the count into the exit status
+class Checks {
+public:
+    // `result` is what was computed; `expected` is only printed when they differ
+    void check(const std::string &name, bool ok, const std::string &result,
+                const std::string &expected = std::string()) {
+        std::cout << (ok ? "ok   " : "FAIL ") << name << ": " << result;
+        if (!ok) {
+            if (!expected.empty()) {
+                std::cout << ", expected " << expected;
+            }
+            failures++;
+        }
+        std::cout << std::endl;
+    }
+
+    int exitStatus() const {
+        if (failures > 0) {
+            std::cerr << failures << " failure(s)" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+private:
+    int failures = 0;
+};
+
+#endif
@@ -0,0 +1,118 @@
+// Checks planBandCrop and SliceLayout::croppedTo against hand-computed cases, so the
+// ScalerCrop band and the slices seen through it can be changed without a camera: a
+// ScalerCrop maximum whose aspect ratio differs from the output's, bands against the
+// bottom edge, band edges that have to be rounded to even rows, and slice layouts
+// clipped to the delivered window (empty outside it). Exits non-zero if any case disagrees.
+//
+// Usage: bandcrop
+
+#include <string>
+#include <vector>
+
+#include "Checks.hpp"
+#include "CropGeometry.hpp"
+#include "SliceLayout.hpp"
+
+struct BandCase {
+    const char* name;
+    CropRect maxCrop;
+    uint32_t outputWidth;
+    uint32_t outputHeight;
+    double bandTop;
+    double bandHeight;
+    CropRect scalerCrop;
+    uint32_t outputRows;
+    uint32_t rowOffset;
+};
+
+// Rectangles are x, y, width, height
+static const CropRect IMX708 = { 0, 0, 4608, 2592 }; // Binned mode: the whole array, 16:9
+static const CropRect IMX219 = { 0, 0, 3280, 2464 }; // Full array, 4:3
+
+static const std::vector<BandCase> BAND_CASES = {
+    { "lower half, matching aspect ratio", IMX708, 640, 360, 0.5, 0.5, { 0, 1296, 4608, 1296 }, 180, 180 },
+    { "4:3 output on a 16:9 maximum: pillarboxed", IMX708, 640, 480, 0.5, 0.5,
+        { 576, 1296, 3456, 1296 }, 240, 240 },
+    { "16:9 output on a 4:3 maximum: letterboxed", IMX219, 640, 360, 0.0, 1.0,
+        { 0, 309, 3280, 1844 }, 360, 0 },
+    { "band running past the bottom edge", IMX708, 640, 480, 0.9, 0.5, { 576, 2332, 3456, 258 }, 48, 432 },
+    { "empty band at the bottom edge keeps two rows", IMX708, 640, 480, 1.0, 0.0,
+        { 576, 2580, 3456, 10 }, 2, 478 },
+    { "odd band edges widened to even rows", IMX708, 640, 480, 0.303, 0.2, { 576, 778, 3456, 528 }, 98, 144 },
+};
+
+static std::string describe(const CropRect &r) {
+    return "(" + std::to_string(r.x) + ", " + std::to_string(r.y) + ")/" + std::to_string(r.width) +
+            "x" + std::to_string(r.height);
+}
+
+static std::string describe(const CropRect &r, uint32_t rows, uint32_t offset) {
+    return describe(r) + ", " + std::to_string(rows) + " rows from " + std::to_string(offset);
+}
+
+static void checkBand(Checks &checks, const BandCase &check) {
+    const BandCrop crop = planBandCrop(check.maxCrop, check.outputWidth, check.outputHeight,
+                                        check.bandTop, check.bandHeight);
+    const CropRect &r = crop.scalerCrop;
+    const CropRect &e = check.scalerCrop;
+    const bool expected = r.x == e.x && r.y == e.y && r.width == e.width && r.height == e.height &&
+                            crop.outputHeight == check.outputRows && crop.rowOffset == check.rowOffset;
+
+    // Whatever the numbers, the ISP needs even rows & a crop inside the maximum
+    const bool valid = crop.outputHeight % 2 == 0 && crop.rowOffset % 2 == 0 && r.height % 2 == 0 &&
+                        r.y >= check.maxCrop.y && r.y + r.height <= check.maxCrop.y + check.maxCrop.height;
+
+    checks.check(check.name, expected && valid, describe(r, crop.outputHeight, crop.rowOffset),
+                    describe(e, check.outputRows, check.rowOffset) + " (even, inside the maximum)");
+}
+
+struct LayoutCase {
+    const char* name;
+    int offset;
+    int height;
+    std::vector<cv::Range> expected;
+};
+
+// Four 120-row slices over a 480-row frame
+static const std::vector<LayoutCase> LAYOUT_CASES = {
+    { "window over the lower half", 240, 240,
+        { cv::Range(0, 0), cv::Range(0, 0), cv::Range(0, 120), cv::Range(120, 240) } },
+    { "window cutting through slices", 180, 240,
+        { cv::Range(0, 0), cv::Range(0, 60), cv::Range(60, 180), cv::Range(180, 240) } },
+    { "window over the top, slices below it", 0, 200,
+        { cv::Range(0, 120), cv::Range(120, 200), cv::Range(200, 200), cv::Range(200, 200) } },
+    { "whole frame", 0, 480,
+        { cv::Range(0, 120), cv::Range(120, 240), cv::Range(240, 360), cv::Range(360, 480) } },
+};
+
+static std::string describe(const std::vector<cv::Range> &rows) {
+    std::string text;
+    for (const cv::Range &range : rows) {
+        text += "[" + std::to_string(range.start) + ", " + std::to_string(range.end) + ") ";
+    }
+    return text;
+}
+
+static void checkLayout(Checks &checks, const SliceLayout &layout, const LayoutCase &check) {
+    const SliceLayout cropped = layout.croppedTo(check.offset, check.height);
+    std::vector<cv::Range> rows;
+    for (int i = 0; i < cropped.size(); i++) {
+        rows.push_back(cropped[i]);
+    }
+    checks.check(check.name, cropped.getHeight() == check.height && rows == check.expected,
+                    describe(rows), describe(check.expected));
+}
+
+int main() {
+    Checks checks;
+    for (const BandCase &check : BAND_CASES) {
+        checkBand(checks, check);
+    }
+
+    const SliceLayout layout = SliceLayout::fromRows(480, {
+        cv::Range(0, 120), cv::Range(120, 240), cv::Range(240, 360), cv::Range(360, 480) });
+    for (const LayoutCase &check : LAYOUT_CASES) {
+        checkLayout(checks, layout, check);
+    }
+    return checks.exitStatus();
+}
@@ -0,0 +1,127 @@
+// Computes the image-to-ground homography used by GroundMapper from one still of a
+// checkerboard lying flat in front of the car, taken with the mounted camera.
+//
+// The board's inner corners are laid out on the ground with the corner row closest to
+// the camera at --distance-mm ahead of the reference point and the board centred
+// --lateral-mm to the right of the camera axis. With --lens the corners are undistorted
+// first; load the same lens calibration on the car alongside the result.
+//
+// Usage: calibrate_ground <image> --board CxR --square-mm S --distance-mm D
+//                         [--lateral-mm L] [--lens PATH] [--output PATH]
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "GroundMapper.hpp"
+
+int main(int argc, char* argv[]) {
+    const char* imagePath = nullptr;
+    const char* outputPath = "data/ground.yml";
+    const char* lensPath = nullptr;
+    cv::Size board;
+    double squareMm = 0;
+    double distanceMm = -1;
+    double lateralMm = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &board.width, &board.height) != 2) {
+                std::cerr << "Board must give inner corners like 9x6" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--square-mm") == 0 && i + 1 < argc) {
+            squareMm = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--distance-mm") == 0 && i + 1 < argc) {
+            distanceMm = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lateral-mm") == 0 && i + 1 < argc) {
+            lateralMm = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lens") == 0 && i + 1 < argc) {
+            lensPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (!imagePath && argv[i][0] != '-') {
+            imagePath = argv[i];
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!imagePath || board.width < 2 || board.height < 2 || squareMm <= 0 || distanceMm < 0) {
+        std::cerr << "Usage: calibrate_ground <image> --board CxR --square-mm S --distance-mm D "
+                     "[--lateral-mm L] [--lens PATH] [--output PATH]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    cv::Mat gray = cv::imread(imagePath, cv::IMREAD_GRAYSCALE);
+    if (gray.empty()) {
+        std::cerr << "Failed to read " << imagePath << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<cv::Point2f> corners;
+    if (!cv::findChessboardCorners(gray, board, corners,
+                                   cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE)) {
+        std::cerr << "No " << board.width << "x" << board.height << " checkerboard found" << std::endl;
+        return EXIT_FAILURE;
+    }
+    cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1),
+                     cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.01));
+
+    if (lensPath) {
+        try {
+            corners = LensModel(lensPath).undistortPoints(corners, gray.size());
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Corners come row by row but in either direction; make them start at the far left
+    if (corners.front().y > corners.back().y) {
+        std::reverse(corners.begin(), corners.end());
+    }
+    if (corners[0].x > corners[board.width - 1].x) {
+        for (int row = 0; row < board.height; row++) {
+            auto first = corners.begin() + row * board.width;
+            std::reverse(first, first + board.width);
+        }
+    }
+
+    // The last (lowest) image row is nearest to the car
+    std::vector<cv::Point2f> ground;
+    for (int row = 0; row < board.height; row++) {
+        for (int column = 0; column < board.width; column++) {
+            ground.emplace_back(static_cast<float>(lateralMm + (column - (board.width - 1) / 2.0) * squareMm),
+                                static_cast<float>(distanceMm + (board.height - 1 - row) * squareMm));
+        }
+    }
+
+    cv::Mat homography = cv::findHomography(corners, ground);
+    if (homography.empty()) {
+        std::cerr << "Failed to fit a homography to the corners" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Report how well the plane fits before writing it out
+    GroundMapper mapper(homography, gray.size());
+    double worstMm = 0;
+    for (size_t i = 0; i < corners.size(); i++) {
+        cv::Point2f mapped = mapper.mapPoint(corners[i]);
+        double errorMm = std::hypot(mapped.x - ground[i].x, mapped.y - ground[i].y);
+        worstMm = std::max(worstMm, errorMm);
+    }
+
+    try {
+        GroundMapper::save(outputPath, homography, gray.size());
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Wrote " << outputPath << " (" << gray.cols << "x" << gray.rows
+                << "), worst corner error " << worstMm << " mm" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+// Checks planControls and lockedPlan against hand-computed cases, so exposure changes
+// can be checked without a sensor: frame durations & exposures clamped to the sensor's
+// limits, a fixed shutter capped at the fixed frame interval (also when the sensor
+// reports no limits), AE switched off once both shutter and gain are fixed, and the
+// plan locked on converged values. Exits non-zero if any case disagrees.
+//
+// Usage: exposureplan
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Checks.hpp"
+#include "ExposurePlan.hpp"
+
+// IMX708 ranges as reported through libcamera (rounded)
+static const SensorLimits IMX708 = { 8333, 112015443, 26, 112015443, 1.0f, 16.0f };
+static const SensorLimits UNREPORTED = {};
+
+struct Expected {
+    int64_t frameDurationUs;
+    int64_t exposureUs;
+    float analogueGain;
+    bool aeEnable;
+    bool lockWhenConverged;
+};
+
+struct Case {
+    const char* name;
+    ExposureSettings settings; // fps, exposureUs, analogueGain, lockWhenConverged
+    const SensorLimits* limits;
+    Expected expected;
+};
+
+static bool matches(const ControlPlan &plan, const Expected &expected) {
+    return plan.frameDurationUs == expected.frameDurationUs && plan.exposureUs == expected.exposureUs &&
+            plan.analogueGain == expected.analogueGain && plan.aeEnable == expected.aeEnable &&
+            plan.lockWhenConverged == expected.lockWhenConverged;
+}
+
+static std::string describe(const ControlPlan &plan) {
+    std::ostringstream out;
+    out << "frame " << plan.frameDurationUs << " us, exposure " << plan.exposureUs << " us, gain "
+        << plan.analogueGain << ", AE " << (plan.aeEnable ? "on" : "off") << ", lock "
+        << (plan.lockWhenConverged ? "yes" : "no");
+    return out.str();
+}
+
+int main() {
+    const std::vector<Case> cases = {
+        { "defaults leave everything to AE", { 0, 0, 0, false }, &IMX708, { 0, 0, 0, true, false } },
+        { "frame rate above the sensor's", { 200, 0, 0, false }, &IMX708, { 8333, 0, 0, true, false } },
+        { "frame rate below the sensor's", { 0.005, 0, 0, false }, &IMX708,
+            { 112015443, 0, 0, true, false } },
+        { "shutter capped at the frame interval", { 60, 30000, 0, false }, &IMX708,
+            { 16667, 16667, 0, true, false } },
+        { "shutter capped without reported limits", { 30, 50000, 0, false }, &UNREPORTED,
+            { 33333, 33333, 0, true, false } },
+        { "shutter past the sensor's maximum", { 0, 200000000, 0, false }, &IMX708,
+            { 0, 112015443, 0, true, false } },
+        { "shutter below the sensor's minimum", { 0, 10, 0, false }, &IMX708, { 0, 26, 0, true, false } },
+        { "gain above the sensor's", { 0, 0, 32.0f, false }, &IMX708, { 0, 0, 16.0f, true, false } },
+        { "gain below the sensor's", { 0, 0, 0.5f, false }, &IMX708, { 0, 0, 1.0f, true, false } },
+        { "fixed shutter keeps AE for gain & can lock", { 30, 5000, 0, true }, &IMX708,
+            { 33333, 5000, 0, true, true } },
+        { "shutter & gain fixed: AE off, nothing to lock", { 30, 5000, 2.0f, true }, &IMX708,
+            { 33333, 5000, 2.0f, false, false } },
+    };
+
+    Checks checks;
+    for (const Case &check : cases) {
+        const ControlPlan plan = planControls(check.settings, *check.limits);
+        checks.check(check.name, matches(plan, check.expected), describe(plan));
+    }
+
+    // Locking keeps the fixed gain & frame interval and fixes AE's shutter & AWB's gains
+    const ControlPlan plan = planControls({ 30, 0, 2.0f, true }, IMX708);
+    const ControlPlan locked = lockedPlan(plan, 12000, 4.0f, 1.8f, 1.5f);
+    checks.check("locked on converged values",
+                    matches(locked, { 33333, 12000, 2.0f, false, false }) && !locked.awbEnable &&
+                    locked.colourGains[0] == 1.8f && locked.colourGains[1] == 1.5f,
+                    describe(locked));
+    return checks.exitStatus();
+}
@@ -0,0 +1,117 @@
+// Runs the full CameraSensor flow (processing, recording & buffer recycling) on
+// FakeFrameSource and reports drops, queue depth & completion-to-release latency.
+//
+// Usage: fakecam [--fps F] [--jitter-us U] [--drop-rate P] [--buffers N]
+//                [--size WxH] [--seconds S] [--record PATH] [--deadlines] [--huge-pages]
+//                [--band TOP,HEIGHT]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "CameraSensor.hpp"
+#include "FakeFrameSource.hpp"
+
+int main(int argc, char* argv[]) {
+    FakeFrameSource::Options options;
+    uint32_t width = 640;
+    uint32_t height = 480;
+    double seconds = 10;
+    const char* recordPath = nullptr;
+    bool deadlines = false;
+    bool hugePages = false;
+    double bandTop = 0;
+    double bandHeight = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.fps = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--jitter-us") == 0 && i + 1 < argc) {
+            options.jitterUs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--drop-rate") == 0 && i + 1 < argc) {
+            options.dropRate = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--buffers") == 0 && i + 1 < argc) {
+            options.bufferCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+                std::cerr << "Size must look like 640x480" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--deadlines") == 0) {
+            deadlines = true;
+        } else if (std::strcmp(argv[i], "--band") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%lf,%lf", &bandTop, &bandHeight) != 2) {
+                std::cerr << "Band must look like 0.5,0.5" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0) {
+            hugePages = true;
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Room for every frame of the run (plus a second of slack), so percentiles cover all of them
+    options.latencySamples = static_cast<size_t>((seconds + 1) * options.fps);
+    auto fake = std::make_unique<FakeFrameSource>(options);
+    FakeFrameSource* source = fake.get();
+    source->setBandOfInterest(bandTop, bandHeight);
+    CameraSensor sensor(std::move(fake), std::make_unique<FrameProcessor>(5, 0.95, 90, 170, false));
+
+    if (sensor.configCamera(width, height, libcamera::formats::XRGB8888,
+                            libcamera::StreamRole::Raw) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (hugePages && sensor.useHugePages(true) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (recordPath && sensor.enableRecording(recordPath, 300, 1) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (deadlines) {
+        sensor.enableDeadlines(options.fps);
+    }
+
+    sensor.startCamera();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    FakeFrameSource::Stats stats = source->getStats();
+
+    std::cout << "Delivered " << stats.delivered << " frames, " << stats.simulatedDrops
+                << " simulated drops, " << stats.underruns << " underruns, max "
+                << stats.maxInFlight << "/" << options.bufferCount << " buffers in flight" << std::endl;
+
+    std::vector<uint64_t> &latencies = stats.latenciesNs;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))];
+        };
+        std::cout << "Completion to release (us): p50 " << percentile(0.5) / 1000
+                    << ", p99 " << percentile(0.99) / 1000
+                    << ", max " << latencies.back() / 1000 << std::endl;
+    }
+
+    if (deadlines) {
+        DeadlineGovernor::Stats deadlineStats = sensor.getDeadlineStats();
+        std::cout << "Deadline misses " << deadlineStats.misses << "/" << deadlineStats.frames
+                    << " at " << deadlineStats.budgetNs / 1000 << " us budget, level "
+                    << deadlineStats.level << " (" << deadlineStats.stepsDown << " down, "
+                    << deadlineStats.stepsUp << " up)" << std::endl;
+    }
+
+    FrameProcessor::MemoryStats memoryStats = sensor.getMemoryStats();
+    std::cout << "Scratch arena " << memoryStats.arenaBytes / 1024 << " KiB"
+                << (memoryStats.hugePages ? " (huge pages)" : "") << ", page faults while processing: "
+                << memoryStats.minorFaults << " minor, " << memoryStats.majorFaults << " major over "
+                << memoryStats.frames << " frames, " << memoryStats.lastMinorFaults << " in the last" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+// Checks every gray extraction kernel in GrayKernels against OpenCV's reference
+// conversion on random frames, then times each one, so the stream can use whichever
+// format the ISP produces most cheaply. The frames have padded strides and widths
+// that aren't whole vectors, and a strip starts at an odd column, so the scalar tails
+// run as well as the vector loops. Exits non-zero if any kernel disagrees by more than the tolerance.
+//
+// Usage: formats [--size WxH] [--iterations N] [--tolerance LEVELS]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "GrayKernels.hpp"
+
+// How OpenCV gets gray from each layout
+struct Reference {
+    uint32_t fourcc;
+    int code;
+    int channels; // Of the Mat handed to cvtColor
+    bool planar;  // 4:2:0 with chroma planes below the Y plane
+};
+
+static const Reference REFERENCES[] = {
+    { FOURCC_XRGB8888, cv::COLOR_BGRA2GRAY, 4, false },
+    { FOURCC_XBGR8888, cv::COLOR_RGBA2GRAY, 4, false },
+    { FOURCC_RGB888, cv::COLOR_BGR2GRAY, 3, false },
+    { FOURCC_BGR888, cv::COLOR_RGB2GRAY, 3, false },
+    { FOURCC_YUYV, cv::COLOR_YUV2GRAY_YUYV, 2, false },
+    { FOURCC_NV12, cv::COLOR_YUV2GRAY_NV12, 1, true },
+    { FOURCC_YUV420, cv::COLOR_YUV2GRAY_I420, 1, true },
+};
+
+static const Reference* findReference(uint32_t fourcc) {
+    for (const Reference &reference : REFERENCES) {
+        if (reference.fourcc == fourcc) {
+            return &reference;
+        }
+    }
+    return nullptr;
+}
+
+// Random bytes in the layout, rows padded past the packed width like an ISP stride
+struct TestFrame {
+    std::vector<uint8_t> bytes;
+    cv::Mat source; // Header over `bytes` in the shape cvtColor expects
+    size_t stride;
+};
+
+static void makeFrame(const Reference &reference, int width, int height, std::mt19937 &random,
+                        TestFrame &frame) {
+    const int rows = reference.planar ? height * 3 / 2 : height;
+    frame.stride = static_cast<size_t>(width) * reference.channels + 32;
+    frame.bytes.resize(frame.stride * rows);
+    for (uint8_t &byte : frame.bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+    frame.source = cv::Mat(rows, width, CV_8UC(reference.channels), frame.bytes.data(), frame.stride);
+}
+
+static int maxDifference(const cv::Mat &a, const cv::Mat &b) {
+    int worst = 0;
+    for (int y = 0; y < a.rows; y++) {
+        const uint8_t* rowA = a.ptr(y);
+        const uint8_t* rowB = b.ptr(y);
+        for (int x = 0; x < a.cols; x++) {
+            worst = std::max(worst, std::abs(rowA[x] - rowB[x]));
+        }
+    }
+    return worst;
+}
+
+// Full conversion with statistics, a strip, and both decimation factors; returns the
+// worst difference from OpenCV and counts statistics that don't add up as failures
+static int checkFormat(const GrayFormat &format, const Reference &reference, int width, int height,
+                        std::mt19937 &random, int &failures) {
+    TestFrame frame;
+    makeFrame(reference, width, height, random, frame);
+    cv::Mat expected;
+    cv::cvtColor(frame.source, expected, reference.code);
+
+    // Three bands of interleaved rows plus rows outside every band
+    const int bands = 3;
+    std::vector<int> rowBands(height);
+    for (int y = 0; y < height; y++) {
+        rowBands[y] = (y % 4 == 3) ? -1 : y % 4;
+    }
+    std::vector<uint64_t> sums(bands);
+    std::vector<uint32_t> histograms(bands * 256);
+    cv::Mat gray(height, width, CV_8UC1);
+    format.toGrayWithStats(frame.bytes.data(), frame.stride, width, height, gray.data, gray.step,
+                            rowBands.data(), bands, sums.data(), histograms.data());
+    int worst = maxDifference(gray, expected);
+
+    std::vector<uint64_t> expectedSums(bands, 0);
+    std::vector<uint32_t> expectedCounts(bands, 0);
+    for (int y = 0; y < height; y++) {
+        if (rowBands[y] >= 0) {
+            for (int x = 0; x < width; x++) {
+                expectedSums[rowBands[y]] += gray.ptr(y)[x];
+            }
+            expectedCounts[rowBands[y]] += width;
+        }
+    }
+    for (int band = 0; band < bands; band++) {
+        uint32_t counted = 0;
+        for (int v = 0; v < 256; v++) {
+            counted += histograms[band * 256 + v];
+        }
+        if (sums[band] != expectedSums[band] || counted != expectedCounts[band]) {
+            std::cerr << "FAIL " << format.name << " " << width << "x" << height
+                        << ": band " << band << " statistics don't match its pixels" << std::endl;
+            failures++;
+        }
+    }
+
+    // A strip from an odd column, converted without statistics (the refine path)
+    const cv::Rect strip(1, 1, width / 2, height / 2);
+    cv::Mat stripGray(strip.height, strip.width, CV_8UC1);
+    format.toGrayWithStats(frame.bytes.data() + strip.y * frame.stride + strip.x * format.bytesPerPixel,
+                            frame.stride, strip.width, strip.height, stripGray.data, stripGray.step,
+                            nullptr, 0, nullptr, nullptr);
+    worst = std::max(worst, maxDifference(stripGray, expected(strip)));
+
+    // Kernels average before converting, OpenCV converts before averaging: allow rounding
+    for (int factor : { 2, 4 }) {
+        const cv::Size size(width / factor, height / factor);
+        cv::Mat decimated(size.height, size.width, CV_8UC1);
+        format.decimateToGray(frame.bytes.data(), frame.stride, width, height, factor,
+                                decimated.data, decimated.step);
+        cv::Mat area;
+        cv::resize(expected(cv::Rect(0, 0, size.width * factor, size.height * factor)), area, size,
+                    0, 0, cv::INTER_AREA);
+        worst = std::max(worst, maxDifference(decimated, area));
+    }
+    return worst;
+}
+
+// Median ns per call over `iterations` calls
+template <typename Call>
+static double timeKernel(int iterations, Call call) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        call();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main(int argc, char* argv[]) {
+    int width = 640;
+    int height = 480;
+    int iterations = 200;
+    int tolerance = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < 8 || height < 8) {
+                std::cerr << "Invalid size: " << argv[i] << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    width &= ~1; // YUV pairs pixels & 4:2:0 needs whole chroma rows
+    height &= ~1;
+
+    std::mt19937 random(1);
+    size_t count = 0;
+    const GrayFormat* formats = grayFormats(count);
+    int failures = 0;
+
+    std::cout << "format,max_diff,convert_ns,decimate2_ns" << std::endl;
+    for (size_t f = 0; f < count; f++) {
+        const GrayFormat &format = formats[f];
+        const Reference* reference = findReference(format.fourcc);
+        if (!reference) {
+            std::cerr << "FAIL " << format.name << ": no OpenCV reference" << std::endl;
+            failures++;
+            continue;
+        }
+
+        // The configured size, then one where no row is whole vectors (odd for RGB; YUV
+        // pairs pixels, so OpenCV wants it even)
+        const int tailWidth = width / 2 + ((reference->channels >= 3) ? 13 : 14);
+        int worst = checkFormat(format, *reference, width, height, random, failures);
+        worst = std::max(worst, checkFormat(format, *reference, tailWidth, (height / 2 + 6) & ~1,
+                                            random, failures));
+        if (worst > tolerance) {
+            std::cerr << "FAIL " << format.name << ": differs from OpenCV by " << worst
+                        << " levels" << std::endl;
+            failures++;
+        }
+
+        TestFrame frame;
+        makeFrame(*reference, width, height, random, frame);
+        cv::Mat gray(height, width, CV_8UC1);
+        std::vector<int> rowBands(height, 0);
+        uint64_t sum;
+
+        // Planar YUV is processed in place: there is no conversion to time
+        const double convertNs = format.inPlace ? 0 : timeKernel(iterations, [&]() {
+            format.toGrayWithStats(frame.bytes.data(), frame.stride, width, height, gray.data, gray.step,
+                                    rowBands.data(), 1, &sum, nullptr);
+        });
+        const double decimateNs = timeKernel(iterations, [&]() {
+            format.decimateToGray(frame.bytes.data(), frame.stride, width, height, 2, gray.data, gray.step);
+        });
+        std::cout << format.name << "," << worst << "," << static_cast<long>(convertNs) << ","
+                    << static_cast<long>(decimateNs) << std::endl;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " failure(s)" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
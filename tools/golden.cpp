@@ -0,0 +1,286 @@
+// Accuracy & performance regression gate over the checked-in golden frames.
+// Runs every FrameProcessor detection mode over data/golden, fails if any slice
+// drifts beyond the tolerance from expected.csv or if ns/frame regresses past
+// the margin against baseline.csv (measured on the car; refresh it there with
+// --update-baseline after an intentional change).
+//
+// Sub-pixel modes are additionally swept over synthetic lines at known fractional
+// positions and must track them within --subpixel-tolerance.
+//
+// Usage: golden [--data DIR] [--tolerance PX] [--subpixel-tolerance PX]
+//               [--margin PERCENT] [--iterations N] [--update-baseline]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "FrameProcessor.hpp"
+
+struct GoldenFrame {
+    std::string name;
+    cv::Mat bgra;
+    std::vector<double> expected;
+};
+
+struct DetectionMode {
+    const char* name;
+    std::function<std::unique_ptr<FrameProcessor>(int slices)> create;
+    bool subpixel = false; // Also checked against the synthetic sub-pixel sweep
+};
+
+// Every detection mode the processor offers; new modes must be added here
+static const std::vector<DetectionMode> MODES = {
+    { "contour", [](int slices) {
+        return std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+    } },
+    { "tracking", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->enableTracking(SliceTracker::Options());
+        return processor;
+    } },
+    { "weighted", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->setCentroidMode(FrameProcessor::CentroidMode::IntensityWeighted);
+        return processor;
+    }, true },
+    { "slice-mean", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->setThresholdMode(FrameProcessor::ThresholdMode::SliceMean);
+        return processor;
+    } },
+    { "previous-mean", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->setThresholdMode(FrameProcessor::ThresholdMode::PreviousSliceMean);
+        return processor;
+    } },
+    { "otsu", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->setThresholdMode(FrameProcessor::ThresholdMode::Otsu);
+        return processor;
+    } },
+    { "pyramid2", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->enablePyramid(2, 24);
+        return processor;
+    } },
+    { "pyramid4", [](int slices) {
+        auto processor = std::make_unique<FrameProcessor>(slices, 0.95, 90, 170, false);
+        processor->enablePyramid(4, 24);
+        return processor;
+    } },
+};
+
+// Renders an anti-aliased vertical tape line centered at a fractional column
+static cv::Mat renderLine(int width, int height, double centerX) {
+    cv::Mat gray(height, width, CV_8UC1);
+    const double halfWidth = 5.0;
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = gray.ptr<uint8_t>(y);
+        for (int x = 0; x < width; x++) {
+            double coverage = std::clamp(0.5 - (std::abs(x - centerX) - halfWidth), 0.0, 1.0);
+            row[x] = static_cast<uint8_t>(std::lround(185 * (1 - coverage) + 40 * coverage));
+        }
+    }
+
+    cv::Mat bgra;
+    cv::cvtColor(gray, bgra, cv::COLOR_GRAY2BGRA);
+    return bgra;
+}
+
+// Sweeps the line across sub-pixel offsets; the float output must follow it closely
+static int checkSubpixel(const DetectionMode &mode, int slices, double tolerance) {
+    const int width = 160;
+    const int height = 120;
+    std::unique_ptr<FrameProcessor> processor = mode.create(slices);
+    std::vector<float> pixels(slices);
+    cv::Mat output;
+    int failures = 0;
+
+    for (double centerX = 60.0; centerX < 62.0; centerX += 0.125) {
+        cv::Mat bgra = renderLine(width, height, centerX);
+        processor->processFrame(output, bgra.rows, bgra.cols, bgra.data);
+        processor->getDistancesF(pixels.data(), nullptr, slices);
+
+        const double expected = width / 2 - centerX;
+        for (int i = 0; i < slices; i++) {
+            if (std::abs(pixels[i] - expected) > tolerance) {
+                std::cerr << "FAIL " << mode.name << " sub-pixel line at " << centerX << " slice " << i
+                            << ": got " << pixels[i] << ", expected " << expected << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    return failures;
+}
+
+static bool loadFrames(const std::string &dir, std::vector<GoldenFrame> &frames) {
+    std::ifstream file(dir + "/expected.csv");
+    if (!file) {
+        std::cerr << "Missing " << dir << "/expected.csv" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::stringstream fields(line);
+        std::string field;
+        GoldenFrame frame;
+        std::getline(fields, frame.name, ',');
+        while (std::getline(fields, field, ',')) {
+            frame.expected.push_back(std::stod(field));
+        }
+
+        cv::Mat gray = cv::imread(dir + "/" + frame.name, cv::IMREAD_GRAYSCALE);
+        if (gray.empty()) {
+            std::cerr << "Failed to read golden frame " << frame.name << std::endl;
+            return false;
+        }
+
+        // Match the camera's XRGB8888 layout so the production path is exercised
+        cv::cvtColor(gray, frame.bgra, cv::COLOR_GRAY2BGRA);
+        frames.push_back(std::move(frame));
+    }
+
+    return !frames.empty();
+}
+
+static std::map<std::string, double> loadBaseline(const std::string &path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t comma = line.find(',');
+        if (comma != std::string::npos) {
+            baseline[line.substr(0, comma)] = std::stod(line.substr(comma + 1));
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = "data/golden";
+    double tolerance = 1.5;
+    double subpixelTolerance = 0.1;
+    double margin = 15.0;
+    int iterations = 50;
+    bool updateBaseline = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--subpixel-tolerance") == 0 && i + 1 < argc) {
+            subpixelTolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--margin") == 0 && i + 1 < argc) {
+            margin = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--update-baseline") == 0) {
+            updateBaseline = true;
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<GoldenFrame> frames;
+    if (!loadFrames(dir, frames)) {
+        return EXIT_FAILURE;
+    }
+
+    const std::string baselinePath = dir + "/baseline.csv";
+    std::map<std::string, double> baseline = loadBaseline(baselinePath);
+    std::map<std::string, double> measured;
+    int failures = 0;
+
+    for (const DetectionMode &mode : MODES) {
+        const int slices = static_cast<int>(frames.front().expected.size());
+        std::unique_ptr<FrameProcessor> processor = mode.create(slices);
+        cv::Mat output;
+
+        // Accuracy: every slice of every frame must land within tolerance. Each frame is
+        // shown twice so modes that carry state between frames are checked when settled.
+        for (const GoldenFrame &frame : frames) {
+            processor->processFrame(output, frame.bgra.rows, frame.bgra.cols, frame.bgra.data);
+            processor->processFrame(output, frame.bgra.rows, frame.bgra.cols, frame.bgra.data);
+            int* distances = processor->getDistances();
+            for (int i = 0; i < slices; i++) {
+                double error = std::abs(distances[i] - frame.expected[i]);
+                if (error > tolerance) {
+                    std::cerr << "FAIL " << mode.name << " " << frame.name << " slice " << i
+                                << ": got " << distances[i] << ", expected " << frame.expected[i]
+                                << std::endl;
+                    failures++;
+                }
+            }
+            delete[] distances;
+        }
+        if (mode.subpixel) {
+            failures += checkSubpixel(mode, slices, subpixelTolerance);
+        }
+
+        // Performance: median over full passes so one preempted pass doesn't count
+        std::vector<double> passes;
+        for (int pass = 0; pass < iterations; pass++) {
+            auto start = std::chrono::steady_clock::now();
+            for (const GoldenFrame &frame : frames) {
+                processor->processFrame(output, frame.bgra.rows, frame.bgra.cols, frame.bgra.data);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            passes.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / frames.size());
+        }
+        std::nth_element(passes.begin(), passes.begin() + passes.size() / 2, passes.end());
+        double nsPerFrame = passes[passes.size() / 2];
+        measured[mode.name] = nsPerFrame;
+
+        std::cout << mode.name << ": " << static_cast<long>(nsPerFrame) << " ns/frame";
+        auto item = baseline.find(mode.name);
+        if (item == baseline.end()) {
+            std::cout << " (no baseline)" << std::endl;
+        } else {
+            double change = (nsPerFrame / item->second - 1.0) * 100.0;
+            std::cout << " (" << (change >= 0 ? "+" : "") << change << "% vs baseline)" << std::endl;
+            if (!updateBaseline && change > margin) {
+                std::cerr << "FAIL " << mode.name << " regressed " << change
+                            << "% (margin " << margin << "%)" << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    if (updateBaseline) {
+        std::ofstream file(baselinePath);
+        file << "# mode, ns per frame\n";
+        for (const auto &[name, nsPerFrame] : measured) {
+            file << name << "," << static_cast<long>(nsPerFrame) << "\n";
+        }
+        std::cout << "Baseline written to " << baselinePath << std::endl;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " golden check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "All golden checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// Measures frame latency (sensor completion to buffer release, i.e. including the
+// processing thread's wake-up) on FakeFrameSource while every CPU is kept busy by
+// stress threads, first with default scheduling and then with SCHED_FIFO, CPU
+// pinning & locked memory. Needs root for the second pass.
+//
+// Usage: jitter [--seconds S] [--fps F] [--size WxH] [--priority P] [--cpu C]
+//               [--stress N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h> // sysconf
+
+#include "CameraSensor.hpp"
+#include "FakeFrameSource.hpp"
+
+// Arithmetic plus a cache-sized memory walk, so the load competes for caches too
+static void stressLoop(const std::atomic<bool> &running) {
+    std::vector<uint8_t> buffer(4 * 1024 * 1024);
+    uint64_t value = 1;
+    while (running.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < buffer.size(); i += 64) {
+            value = value * 6364136223846793005ULL + buffer[i];
+            buffer[i] = static_cast<uint8_t>(value >> 56);
+        }
+    }
+}
+
+static void report(const char* name, std::vector<uint64_t> latencies) {
+    if (latencies.empty()) {
+        std::cout << name << ": no frames" << std::endl;
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))] / 1000.0;
+    };
+    std::cout << name << " (" << latencies.size() << " frames, us): p50 " << percentile(0.5)
+                << ", p99 " << percentile(0.99) << ", p99.9 " << percentile(0.999)
+                << ", max " << latencies.back() / 1000.0 << std::endl;
+}
+
+static bool runPass(const FakeFrameSource::Options &options, uint32_t width, uint32_t height,
+                    double seconds, const ThreadPolicy* policy, std::vector<uint64_t> &latencies) {
+    auto fake = std::make_unique<FakeFrameSource>(options);
+    FakeFrameSource* source = fake.get();
+    CameraSensor sensor(std::move(fake), std::make_unique<FrameProcessor>(5, 0.95, 90, 170, false));
+
+    if (sensor.configCamera(width, height, libcamera::formats::XRGB8888,
+                            libcamera::StreamRole::Raw) != 0) {
+        return false;
+    }
+    if (policy && (sensor.lockMemory() != 0 ||
+                   sensor.setThreadPolicy(CameraSensor::ThreadRole::Processing, *policy) != 0)) {
+        return false;
+    }
+
+    sensor.startCamera();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    latencies = source->getStats().latenciesNs;
+
+    // setThreadPolicy only queues it: the processing thread reports how applying went
+    if (policy) {
+        const int result = sensor.getProcessingPolicyResult();
+        if (result != 0) {
+            std::cerr << "Processing thread policy not applied: " << std::strerror(-result) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    FakeFrameSource::Options options;
+    uint32_t width = 640;
+    uint32_t height = 480;
+    double seconds = 20;
+    ThreadPolicy policy;
+    policy.priority = 80;
+    policy.cpu = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN)) - 1;
+    int stressThreads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.fps = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+                std::cerr << "Size must look like 640x480" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--priority") == 0 && i + 1 < argc) {
+            policy.priority = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            policy.cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stressThreads = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    options.jitterUs = 0;
+    options.dropRate = 0;
+    options.latencySamples = static_cast<size_t>((seconds + 1) * options.fps);
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> stress;
+    for (int i = 0; i < stressThreads; i++) {
+        stress.emplace_back(stressLoop, std::cref(running));
+    }
+    std::cout << "Stressing with " << stressThreads << " threads, " << seconds
+                << " s per pass at " << options.fps << " fps" << std::endl;
+
+    // Default scheduling first: mlockall can't be undone within the process
+    std::vector<uint64_t> latencies;
+    bool ok = runPass(options, width, height, seconds, nullptr, latencies);
+    if (ok) {
+        report("SCHED_OTHER", latencies);
+        ok = runPass(options, width, height, seconds, &policy, latencies);
+        if (ok) {
+            report("SCHED_FIFO + pinned + mlockall", latencies);
+        } else {
+            std::cerr << "Real-time pass failed (run as root?)" << std::endl;
+        }
+    }
+
+    running = false;
+    for (std::thread &thread : stress) {
+        thread.join();
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,125 @@
+// Checks the per-slice line-present flag & confidence on canned synthetic frames: a
+// solid line, an empty frame right after it (present drops, the distance is left over
+// from the line), a faint line and a shadow covering most of the slice (both found,
+// but trusted less). Every case is read through getSnapshot and must agree with
+// getDistancesF & getStatus. Exits non-zero on any mismatch.
+//
+// Usage: presence [--slices N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FrameProcessor.hpp"
+
+static const int WIDTH = 160;
+static const int HEIGHT = 120;
+static const int BACKGROUND = 185;
+
+// Vertical band of `level` from column left to right (exclusive) on the background
+static cv::Mat renderBand(int left, int right, int level) {
+    cv::Mat gray(HEIGHT, WIDTH, CV_8UC1, cv::Scalar(BACKGROUND));
+    if (right > left) {
+        gray.colRange(left, right).setTo(cv::Scalar(level));
+    }
+
+    cv::Mat bgra;
+    cv::cvtColor(gray, bgra, cv::COLOR_GRAY2BGRA);
+    return bgra;
+}
+
+struct Case {
+    const char* name;
+    cv::Mat frame;
+    bool present;
+    float minConfidence;
+    float maxConfidence;
+    bool checkDistance;
+    float distancePx; // Expected even when absent: the earlier frame's value stays
+};
+
+static int checkCase(FrameProcessor &processor, const Case &check, uint64_t sequence, int slices) {
+    cv::Mat output;
+    processor.processFrame(output, check.frame.rows, check.frame.cols, check.frame.data, sequence);
+
+    std::vector<SliceResult> snapshot(slices);
+    std::vector<SliceStatus> statuses(slices);
+    std::vector<float> pixels(slices);
+    std::vector<float> normalized(slices);
+    int failures = 0;
+    if (processor.getSnapshot(snapshot.data(), slices) != slices ||
+        processor.getStatus(statuses.data(), slices) != slices ||
+        processor.getDistancesF(pixels.data(), normalized.data(), slices) != slices) {
+        std::cerr << "FAIL " << check.name << ": not every slice was copied" << std::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < slices; i++) {
+        const SliceResult &result = snapshot[i];
+        const std::string where = std::string(check.name) + " slice " + std::to_string(i);
+        if (result.distancePx != pixels[i] || result.distanceNorm != normalized[i] ||
+            std::memcmp(&result.status, &statuses[i], sizeof(SliceStatus)) != 0) {
+            std::cerr << "FAIL " << where << ": snapshot differs from getDistancesF/getStatus" << std::endl;
+            failures++;
+        }
+        if ((result.status.present != 0) != check.present || result.status.refreshed != 1 ||
+            result.status.sequence != sequence) {
+            std::cerr << "FAIL " << where << ": present " << result.status.present << ", refreshed "
+                        << result.status.refreshed << ", sequence " << result.status.sequence
+                        << " (expected present " << check.present << " in frame " << sequence << ")" << std::endl;
+            failures++;
+        }
+        if (result.status.confidence < check.minConfidence || result.status.confidence > check.maxConfidence) {
+            std::cerr << "FAIL " << where << ": confidence " << result.status.confidence << " outside ["
+                        << check.minConfidence << ", " << check.maxConfidence << "]" << std::endl;
+            failures++;
+        }
+        if (check.checkDistance && std::abs(result.distancePx - check.distancePx) > 1.0f) {
+            std::cerr << "FAIL " << where << ": distance " << result.distancePx << ", expected "
+                        << check.distancePx << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << check.name << ": present " << snapshot[0].status.present << ", confidence "
+                << snapshot[0].status.confidence << ", distance " << snapshot[0].distancePx << std::endl;
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    int slices = 5;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--slices") == 0 && i + 1 < argc) {
+            slices = std::clamp(std::atoi(argv[++i]), 1, HEIGHT / 8);
+        } else {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Line centered at column 100, i.e. 20 px right of the middle
+    const float lineDistance = WIDTH / 2 - 100.0f;
+    const std::vector<Case> cases = {
+        { "solid line", renderBand(95, 105, 40), true, 0.8f, 1.0f, true, lineDistance },
+        { "empty frame", renderBand(0, 0, 40), false, 0.0f, 0.0f, true, lineDistance },
+        { "faint line", renderBand(95, 105, 160), true, 0.05f, 0.6f, true, lineDistance },
+        { "shadow", renderBand(0, WIDTH * 3 / 4, 40), true, 0.0f, 0.55f, false, 0.0f },
+    };
+
+    FrameProcessor processor(slices, 0.95, 90, 170, false);
+    int failures = 0;
+    uint64_t sequence = 1;
+    for (const Case &check : cases) {
+        failures += checkCase(processor, check, sequence++, slices);
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " failure(s)" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
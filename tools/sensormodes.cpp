@@ -0,0 +1,89 @@
+// Checks selectSensorMode against canned mode lists, so a change to the selection rules
+// shows up without a camera attached. The lists are what libcamera enumerates for the
+// IMX708 (Camera Module 3), plus variants for the edge cases: modes cropped by a few
+// alignment pixels, frame rates within rounding of each other, and nothing fitting.
+// Prints every case and exits non-zero if any picks the wrong mode.
+//
+// Usage: sensormodes
+
+#include <string>
+#include <vector>
+
+#include "Checks.hpp"
+#include "SensorModes.hpp"
+
+static const uint32_t ARRAY_WIDTH = 4608;
+static const uint32_t ARRAY_HEIGHT = 2592;
+
+// Entries are width, height, bit depth, max fps, then the crop as x, y, width, height
+
+// As enumerated on a Pi: the fast mode bins a centre crop, the others see it all
+static const std::vector<SensorMode> IMX708 = {
+    { 1536, 864, 10, 120.13, 768, 432, 3072, 1728 },
+    { 2304, 1296, 10, 56.03, 0, 0, 4608, 2592 },
+    { 4608, 2592, 10, 14.35, 0, 0, 4608, 2592 },
+};
+
+// Binned full-view mode trimmed by alignment pixels next to the cropped fast mode
+static const std::vector<SensorMode> TRIMMED = {
+    { 1536, 864, 10, 120.13, 768, 432, 3072, 1728 },
+    { 2304, 1296, 10, 56.03, 16, 8, 4576, 2576 },
+};
+
+// A driver that reports no crop at all
+static const std::vector<SensorMode> UNCROPPED = {
+    { 1152, 648, 10, 30.0, 0, 0, 0, 0 },
+};
+
+// Frame rates 0.37 apart are a tie (fewer pixels wins); a frame apart is not
+static const std::vector<SensorMode> NEAR_TIE = {
+    { 2304, 1296, 10, 56.03, 0, 0, 4608, 2592 },
+    { 1920, 1080, 10, 56.40, 0, 0, 4608, 2592 },
+};
+static const std::vector<SensorMode> FAR_APART = {
+    { 2304, 1296, 10, 56.03, 0, 0, 4608, 2592 },
+    { 1280, 720, 10, 55.00, 0, 0, 4608, 2592 },
+};
+
+static const std::vector<SensorMode> NONE;
+
+struct Case {
+    const char* name;
+    const std::vector<SensorMode>* modes;
+    SensorModeRequirements requirements;
+    int expected;
+};
+
+// Fastest mode for the output, optionally limited to a field of view
+static SensorModeRequirements fastest(uint32_t width, uint32_t height, double minFps, double fovX = 0,
+                                        double fovY = 0, double fovWidth = 1, double fovHeight = 1) {
+    return { SensorModeRequirements::Policy::MaxFps, width, height, minFps, fovX, fovY, fovWidth, fovHeight };
+}
+
+int main() {
+    const std::vector<Case> cases = {
+        { "default policy leaves it to libcamera", &IMX708, SensorModeRequirements(), -1 },
+        { "full view rules out the cropped 120 fps mode", &IMX708, fastest(640, 480, 0), 1 },
+        { "centre view allows the cropped 120 fps mode", &IMX708, fastest(640, 480, 0, 0.2, 0.2, 0.6, 0.6), 0 },
+        { "view just past the crop's left edge", &IMX708, fastest(640, 480, 0, 0.14, 0.2, 0.6, 0.6), 1 },
+        { "view within the crop's left edge tolerance", &IMX708, fastest(640, 480, 0, 0.16, 0.2, 0.6, 0.6), 0 },
+        { "output larger than the fast mode", &IMX708, fastest(1920, 1080, 0), 1 },
+        { "full resolution output", &IMX708, fastest(4608, 2592, 0), 2 },
+        { "alignment trim still counts as full view", &TRIMMED, fastest(640, 480, 0), 1 },
+        { "no crop reported means full view", &UNCROPPED, fastest(640, 480, 0), 0 },
+        { "fps within rounding: fewer pixels wins", &NEAR_TIE, fastest(640, 480, 0), 1 },
+        { "fps a frame apart: faster wins", &FAR_APART, fastest(640, 480, 0), 0 },
+        { "no mode fast enough at full view", &IMX708, fastest(640, 480, 100), -1 },
+        { "no mode large enough", &IMX708, fastest(5000, 3000, 0), -1 },
+        { "full resolution too slow", &IMX708, fastest(4608, 2592, 30), -1 },
+        { "empty mode list", &NONE, fastest(640, 480, 0), -1 },
+    };
+
+    Checks checks;
+    for (const Case &check : cases) {
+        const int selected = selectSensorMode(*check.modes, check.requirements, ARRAY_WIDTH, ARRAY_HEIGHT);
+        checks.check(check.name, selected == check.expected, "mode " + std::to_string(selected),
+                        std::to_string(check.expected));
+    }
+    return checks.exitStatus();
+}